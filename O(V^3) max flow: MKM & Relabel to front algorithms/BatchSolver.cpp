@@ -0,0 +1,153 @@
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include "src.cpp"
+
+#ifndef _BATCH_SOLVER_
+#define _BATCH_SOLVER_
+
+namespace NFlow {
+    namespace NInner {
+
+        enum TBatchEngine {BATCH_MAL_CUM_MAH, BATCH_RELABEL_TO_FRONT};
+
+        // Solves many independent networks on a fixed pool of threads started once in the constructor.
+        // Workers take the networks in chunks from a shared counter and keep one workspace per engine,
+        // so the solver buffers are allocated for the largest network a worker meets, not for every network.
+        // The results are the maximum flows in the order of the input; an exception thrown by a solver
+        // is passed on by solve after the whole batch is finished.
+        class BatchSolver {
+        private:
+            struct Worker {
+                MalCumMahWorkspace malCumMahWorkspace;
+                RelabelToFrontWorkspace relabelToFrontWorkspace;
+            };
+
+            static const size_t CHUNK_SIZE = 16;
+
+            std::vector<Worker> workers_;
+            std::vector<std::thread> threads_;
+            std::mutex mutex_;
+            std::condition_variable start_;
+            std::condition_variable finish_;
+            size_t generation_;
+            size_t running_;
+            bool stop_;
+
+            std::vector<Network>* networks_;
+            std::vector<TFlow>* results_;
+            TBatchEngine engine_;
+            std::atomic<size_t> next_;
+            std::exception_ptr error_;
+
+            TFlow solveOne (Worker& worker, Network& network) {
+                if (engine_ == BATCH_RELABEL_TO_FRONT) {
+                    RelabelToFront algorithm(network, std::move(worker.relabelToFrontWorkspace));
+                    TFlow flow = algorithm.getMaxFlow();
+                    worker.relabelToFrontWorkspace = algorithm.releaseWorkspace();
+                    return flow;
+                }
+                MalCumMah algorithm(network, std::move(worker.malCumMahWorkspace));
+                TFlow flow = algorithm.getMaxFlow();
+                worker.malCumMahWorkspace = algorithm.releaseWorkspace();
+                return flow;
+            }
+
+            void process (Worker& worker) {
+                size_t size = networks_->size();
+                while (true) {
+                    size_t begin = next_.fetch_add(CHUNK_SIZE);
+                    if (begin >= size) {
+                        return;
+                    }
+                    size_t end = std::min(begin + CHUNK_SIZE, size);
+                    for (size_t index = begin; index < end; ++index) {
+                        (*results_)[index] = solveOne(worker, (*networks_)[index]);
+                    }
+                }
+            }
+
+            void work (size_t workerIndex) {
+                size_t seenGeneration = 0;
+                while (true) {
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        start_.wait(lock, [&] { return stop_ || generation_ != seenGeneration; });
+                        if (stop_) {
+                            return;
+                        }
+                        seenGeneration = generation_;
+                    }
+                    try {
+                        process(workers_[workerIndex]);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        if (!error_) {
+                            error_ = std::current_exception();
+                        }
+                        next_ = networks_->size();
+                    }
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (--running_ == 0) {
+                        finish_.notify_one();
+                    }
+                }
+            }
+
+        public:
+            BatchSolver (size_t threadNumber = std::thread::hardware_concurrency()): workers_(std::max(threadNumber, static_cast<size_t>(1))),
+                                                                                     generation_(0), running_(0), stop_(false),
+                                                                                     networks_(nullptr), results_(nullptr), engine_(BATCH_MAL_CUM_MAH), next_(0) {
+                for (size_t workerIndex = 0; workerIndex < workers_.size(); ++workerIndex) {
+                    threads_.emplace_back(&BatchSolver::work, this, workerIndex);
+                }
+            }
+
+            ~BatchSolver () {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    stop_ = true;
+                }
+                start_.notify_all();
+                for (size_t thread = 0; thread < threads_.size(); ++thread) {
+                    threads_[thread].join();
+                }
+            }
+
+            BatchSolver (const BatchSolver&) = delete;
+
+            BatchSolver& operator = (const BatchSolver&) = delete;
+
+            size_t getThreadNumber () const {
+                return threads_.size();
+            }
+
+            // The networks keep their flows, one call at a time.
+            std::vector<TFlow> solve (std::vector<Network>& networks, TBatchEngine engine = BATCH_MAL_CUM_MAH) {
+                std::vector<TFlow> results(networks.size(), static_cast<TFlow>(0));
+                if (networks.empty()) {
+                    return results;
+                }
+                std::unique_lock<std::mutex> lock(mutex_);
+                networks_ = &networks;
+                results_ = &results;
+                engine_ = engine;
+                next_ = 0;
+                error_ = nullptr;
+                running_ = threads_.size();
+                ++generation_;
+                start_.notify_all();
+                finish_.wait(lock, [&] { return running_ == 0; });
+                networks_ = nullptr;
+                results_ = nullptr;
+                if (error_) {
+                    std::rethrow_exception(error_);
+                }
+                return results;
+            }
+        };
+    }
+}
+#endif
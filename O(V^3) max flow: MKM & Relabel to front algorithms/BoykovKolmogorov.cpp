@@ -0,0 +1,509 @@
+#include "src.cpp"
+
+#ifndef _BOYKOV_KOLMOGOROV_
+#define _BOYKOV_KOLMOGOROV_
+
+namespace NFlow {
+    namespace NInner {
+
+        struct InvalidDirection : public std::exception {};
+
+        // Implicit width x height x depth grid with 4 (depth == 1) or 6 neighbours, the source and the sink are
+        // joined to every vertex by terminal links. Arcs are computed from the vertex index, only the residual
+        // capacities are stored: residual_[vertex * directionNumber_ + direction] and the terminal residual
+        // terminal_[vertex], positive towards the source and negative towards the sink.
+        // Directions are +x, -x, +y, -y, +z, -z, so the reversed direction is direction ^ 1.
+        template <class TCapacity>
+        class BasicGridNetwork {
+        private:
+            int width_, height_, depth_;
+            int directionNumber_;
+            TVertex vertexNumber_;
+            TVertex offset_[6];
+            std::vector<TCapacity> residual_;
+            std::vector<TCapacity> terminal_;
+            std::vector<unsigned char> neighbours_;
+            TFlow flow_;
+
+            template <class T>
+            friend class BasicBoykovKolmogorov;
+
+        public:
+            BasicGridNetwork (int width, int height, int depth = 1): width_(width), height_(height), depth_(depth), directionNumber_(depth > 1 ? 6 : 4),
+                                                                    vertexNumber_(static_cast<TVertex>(width) * height * depth), flow_(static_cast<TFlow>(0)) {
+                if (width <= 0 || height <= 0 || depth <= 0) {
+                    throw InvalidVertex();
+                }
+                offset_[0] = 1;
+                offset_[1] = -1;
+                offset_[2] = width;
+                offset_[3] = -width;
+                offset_[4] = static_cast<TVertex>(width) * height;
+                offset_[5] = -static_cast<TVertex>(width) * height;
+                residual_.assign(vertexNumber_ * directionNumber_, static_cast<TCapacity>(0));
+                terminal_.assign(vertexNumber_, static_cast<TCapacity>(0));
+                neighbours_.assign(vertexNumber_, 0);
+                for (int z = 0; z < depth; ++z) {
+                    for (int y = 0; y < height; ++y) {
+                        for (int x = 0; x < width; ++x) {
+                            unsigned char mask = 0;
+                            mask |= (x + 1 < width) << 0;
+                            mask |= (x > 0) << 1;
+                            mask |= (y + 1 < height) << 2;
+                            mask |= (y > 0) << 3;
+                            mask |= (z + 1 < depth) << 4;
+                            mask |= (z > 0) << 5;
+                            neighbours_[getVertex(x, y, z)] = mask;
+                        }
+                    }
+                }
+            }
+
+            int getWidth () const {
+                return width_;
+            }
+
+            int getHeight () const {
+                return height_;
+            }
+
+            int getDepth () const {
+                return depth_;
+            }
+
+            TVertex getVertexNumber () const {
+                return vertexNumber_;
+            }
+
+            int getDirectionNumber () const {
+                return directionNumber_;
+            }
+
+            TVertex getVertex (int x, int y, int z = 0) const {
+                if (x < 0 || x >= width_ || y < 0 || y >= height_ || z < 0 || z >= depth_) {
+                    throw InvalidVertex();
+                }
+                return (static_cast<TVertex>(z) * height_ + y) * width_ + x;
+            }
+
+            bool hasNeighbour (TVertex vertex, int direction) const {
+                return (neighbours_[vertex] >> direction) & 1;
+            }
+
+            TVertex getNeighbour (TVertex vertex, int direction) const {
+                return vertex + offset_[direction];
+            }
+
+            static int getReversedDirection (int direction) {
+                return direction ^ 1;
+            }
+
+            void addEdge (TVertex vertex, int direction, TCapacity cap, TCapacity reversedCap = static_cast<TCapacity>(0)) {
+                if (vertex < 0 || vertex >= vertexNumber_) {
+                    throw InvalidVertex();
+                }
+                if (direction < 0 || direction >= directionNumber_ || !hasNeighbour(vertex, direction)) {
+                    throw InvalidDirection();
+                }
+                if (cap < static_cast<TCapacity>(0) || reversedCap < static_cast<TCapacity>(0)) {
+                    throw NegativeCapacityException();
+                }
+                residual_[vertex * directionNumber_ + direction] += cap;
+                residual_[getNeighbour(vertex, direction) * directionNumber_ + getReversedDirection(direction)] += reversedCap;
+            }
+
+            // The common part of the two links is sent as flow source -> vertex -> sink right away.
+            void addTerminalCapacity (TVertex vertex, TCapacity sourceCap, TCapacity sinkCap) {
+                if (vertex < 0 || vertex >= vertexNumber_) {
+                    throw InvalidVertex();
+                }
+                if (sourceCap < static_cast<TCapacity>(0) || sinkCap < static_cast<TCapacity>(0)) {
+                    throw NegativeCapacityException();
+                }
+                if (terminal_[vertex] > static_cast<TCapacity>(0)) {
+                    sourceCap += terminal_[vertex];
+                } else {
+                    sinkCap -= terminal_[vertex];
+                }
+                flow_ += std::min(sourceCap, sinkCap);
+                terminal_[vertex] = sourceCap - sinkCap;
+            }
+
+            TCapacity getResidualCapacity (TVertex vertex, int direction) const {
+                return residual_[vertex * directionNumber_ + direction];
+            }
+
+            TCapacity getTerminalResidual (TVertex vertex) const {
+                return terminal_[vertex];
+            }
+
+            TFlow getFlow () const {
+                return flow_;
+            }
+        };
+
+        typedef BasicGridNetwork<TFlow> GridNetwork;
+
+        // Boykov-Kolmogorov: a source search tree and a sink search tree grow over the residual grid until they touch,
+        // the path is augmented and the trees are repaired by adopting the orphans instead of being rebuilt.
+        // Orphans are adopted by the neighbour closest to its terminal, distances are cached with timestamps.
+        // The trees survive getMaxFlow: after raising capacities call markVertex for every vertex whose terminal
+        // link changed and for both ends of every changed arc, the next getMaxFlow continues from the old trees.
+        template <class TCapacity>
+        class BasicBoykovKolmogorov: public Algorithm {
+        private:
+            enum TTree {FREE, SOURCE_TREE, SINK_TREE};
+
+            static const unsigned char TERMINAL = 6;
+            static const unsigned char ORPHAN = 7;
+            static const unsigned char NO_PARENT = 8;
+            static const TVertex NO_VERTEX = -1;
+
+            BasicGridNetwork<TCapacity>& grid_;
+            TVertex vertexNumber_;
+            int directionNumber_;
+            bool initialized_;
+            int time_;
+
+            std::vector<unsigned char> tree_;
+            std::vector<unsigned char> parent_;
+            std::vector<int> timestamp_;
+            std::vector<int> distance_;
+            std::vector<TVertex> nextActive_;
+            TVertex firstActive_, lastActive_;
+            std::vector<TVertex> orphans_;
+            std::vector<TVertex> marked_;
+            Statistics statistics_;
+
+            TCapacity& residual (TVertex vertex, int direction) {
+                return grid_.residual_[vertex * directionNumber_ + direction];
+            }
+
+            TTree getTerminalTree (TVertex vertex) const {
+                if (grid_.terminal_[vertex] > static_cast<TCapacity>(0)) {
+                    return SOURCE_TREE;
+                }
+                if (grid_.terminal_[vertex] < static_cast<TCapacity>(0)) {
+                    return SINK_TREE;
+                }
+                return FREE;
+            }
+
+            // The last active vertex points to itself, so nextActive_ == NO_VERTEX means not queued.
+            void setActive (TVertex vertex) {
+                if (nextActive_[vertex] != NO_VERTEX) {
+                    return;
+                }
+                if (lastActive_ == NO_VERTEX) {
+                    firstActive_ = vertex;
+                } else {
+                    nextActive_[lastActive_] = vertex;
+                }
+                lastActive_ = vertex;
+                nextActive_[vertex] = vertex;
+            }
+
+            TVertex popActive () {
+                TVertex vertex = firstActive_;
+                if (vertex == NO_VERTEX) {
+                    return NO_VERTEX;
+                }
+                firstActive_ = nextActive_[vertex] == vertex ? NO_VERTEX : nextActive_[vertex];
+                if (firstActive_ == NO_VERTEX) {
+                    lastActive_ = NO_VERTEX;
+                }
+                nextActive_[vertex] = NO_VERTEX;
+                return vertex;
+            }
+
+            void attachToTerminal (TVertex vertex, TTree tree) {
+                tree_[vertex] = tree;
+                parent_[vertex] = TERMINAL;
+                timestamp_[vertex] = time_;
+                distance_[vertex] = 1;
+                setActive(vertex);
+            }
+
+            void makeOrphan (TVertex vertex) {
+                parent_[vertex] = ORPHAN;
+                orphans_.push_back(vertex);
+            }
+
+            // Looks for a tree vertex next to a source tree vertex (or the other way round) through a residual arc,
+            // growing the tree of the vertex over the free neighbours meanwhile. Returns the direction of the arc or -1.
+            int grow (TVertex vertex) {
+                bool sourceTree = tree_[vertex] == SOURCE_TREE;
+                for (int direction = 0; direction < directionNumber_; ++direction) {
+                    if (!grid_.hasNeighbour(vertex, direction)) {
+                        continue;
+                    }
+                    TVertex neighbour = grid_.getNeighbour(vertex, direction);
+                    TCapacity cap = sourceTree ? residual(vertex, direction) : residual(neighbour, direction ^ 1);
+                    if (cap == static_cast<TCapacity>(0)) {
+                        continue;
+                    }
+                    if (tree_[neighbour] == FREE) {
+                        tree_[neighbour] = tree_[vertex];
+                        parent_[neighbour] = direction ^ 1;
+                        timestamp_[neighbour] = timestamp_[vertex];
+                        distance_[neighbour] = distance_[vertex] + 1;
+                        setActive(neighbour);
+                    } else if (tree_[neighbour] != tree_[vertex]) {
+                        return direction;
+                    } else if (timestamp_[neighbour] <= timestamp_[vertex] && distance_[neighbour] > distance_[vertex]) {
+                        parent_[neighbour] = direction ^ 1;
+                        timestamp_[neighbour] = timestamp_[vertex];
+                        distance_[neighbour] = distance_[vertex] + 1;
+                    }
+                }
+                return -1;
+            }
+
+            // The path goes from the source to start inside the source tree, over the arc (start, direction)
+            // and from its head to the sink inside the sink tree.
+            void augment (TVertex start, int direction) {
+                TVertex finish = grid_.getNeighbour(start, direction);
+                TCapacity change = residual(start, direction);
+                TVertex vertex = start;
+                for (; parent_[vertex] != TERMINAL; vertex = grid_.getNeighbour(vertex, parent_[vertex])) {
+                    TVertex parent = grid_.getNeighbour(vertex, parent_[vertex]);
+                    change = std::min(change, residual(parent, parent_[vertex] ^ 1));
+                }
+                change = std::min(change, grid_.terminal_[vertex]);
+                for (vertex = finish; parent_[vertex] != TERMINAL; vertex = grid_.getNeighbour(vertex, parent_[vertex])) {
+                    change = std::min(change, residual(vertex, parent_[vertex]));
+                }
+                change = std::min(change, static_cast<TCapacity>(-grid_.terminal_[vertex]));
+
+                residual(start, direction) -= change;
+                residual(finish, direction ^ 1) += change;
+                for (vertex = start; parent_[vertex] != TERMINAL; ) {
+                    int parentDirection = parent_[vertex];
+                    TVertex parent = grid_.getNeighbour(vertex, parentDirection);
+                    residual(parent, parentDirection ^ 1) -= change;
+                    residual(vertex, parentDirection) += change;
+                    if (residual(parent, parentDirection ^ 1) == static_cast<TCapacity>(0)) {
+                        makeOrphan(vertex);
+                    }
+                    vertex = parent;
+                }
+                grid_.terminal_[vertex] -= change;
+                if (grid_.terminal_[vertex] == static_cast<TCapacity>(0)) {
+                    makeOrphan(vertex);
+                }
+                for (vertex = finish; parent_[vertex] != TERMINAL; ) {
+                    int parentDirection = parent_[vertex];
+                    TVertex parent = grid_.getNeighbour(vertex, parentDirection);
+                    residual(vertex, parentDirection) -= change;
+                    residual(parent, parentDirection ^ 1) += change;
+                    if (residual(vertex, parentDirection) == static_cast<TCapacity>(0)) {
+                        makeOrphan(vertex);
+                    }
+                    vertex = parent;
+                }
+                grid_.terminal_[vertex] += change;
+                if (grid_.terminal_[vertex] == static_cast<TCapacity>(0)) {
+                    makeOrphan(vertex);
+                }
+                grid_.flow_ += change;
+                ++statistics_.augmentations;
+            }
+
+            // Distance from vertex to its terminal along the tree, INF when the way up meets an orphan.
+            // Vertices on a valid way get the current timestamp and their exact distances.
+            int getOriginDistance (TVertex vertex) {
+                int distance = 0;
+                TVertex cur = vertex;
+                while (true) {
+                    if (timestamp_[cur] == time_) {
+                        distance += distance_[cur];
+                        break;
+                    }
+                    ++distance;
+                    if (parent_[cur] == TERMINAL) {
+                        timestamp_[cur] = time_;
+                        distance_[cur] = 1;
+                        break;
+                    }
+                    if (parent_[cur] == ORPHAN) {
+                        return INF;
+                    }
+                    cur = grid_.getNeighbour(cur, parent_[cur]);
+                }
+                int result = distance;
+                for (cur = vertex; timestamp_[cur] != time_; cur = grid_.getNeighbour(cur, parent_[cur])) {
+                    timestamp_[cur] = time_;
+                    distance_[cur] = distance--;
+                }
+                return result;
+            }
+
+            void adopt (TVertex vertex) {
+                TTree tree = static_cast<TTree>(tree_[vertex]);
+                TTree terminalTree = getTerminalTree(vertex);
+                if (terminalTree == tree) {
+                    parent_[vertex] = TERMINAL;
+                    timestamp_[vertex] = time_;
+                    distance_[vertex] = 1;
+                    return;
+                }
+                int bestDirection = -1;
+                int bestDistance = INF;
+                for (int direction = 0; direction < directionNumber_ && terminalTree == FREE; ++direction) {
+                    if (!grid_.hasNeighbour(vertex, direction)) {
+                        continue;
+                    }
+                    TVertex neighbour = grid_.getNeighbour(vertex, direction);
+                    TCapacity cap = tree == SOURCE_TREE ? residual(neighbour, direction ^ 1) : residual(vertex, direction);
+                    if (tree_[neighbour] != tree || cap == static_cast<TCapacity>(0)) {
+                        continue;
+                    }
+                    int distance = getOriginDistance(neighbour);
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        bestDirection = direction;
+                    }
+                }
+                if (bestDirection != -1) {
+                    parent_[vertex] = bestDirection;
+                    timestamp_[vertex] = time_;
+                    distance_[vertex] = bestDistance + 1;
+                    return;
+                }
+                for (int direction = 0; direction < directionNumber_; ++direction) {
+                    if (!grid_.hasNeighbour(vertex, direction)) {
+                        continue;
+                    }
+                    TVertex neighbour = grid_.getNeighbour(vertex, direction);
+                    if (tree_[neighbour] != tree) {
+                        continue;
+                    }
+                    TCapacity cap = tree == SOURCE_TREE ? residual(neighbour, direction ^ 1) : residual(vertex, direction);
+                    if (cap > static_cast<TCapacity>(0)) {
+                        setActive(neighbour);
+                    }
+                    if (parent_[neighbour] == (direction ^ 1)) {
+                        makeOrphan(neighbour);
+                    }
+                }
+                tree_[vertex] = FREE;
+                parent_[vertex] = NO_PARENT;
+                if (terminalTree != FREE) {
+                    attachToTerminal(vertex, terminalTree);
+                }
+            }
+
+            void adoptOrphans () {
+                for (size_t i = 0; i < orphans_.size(); ++i) {
+                    adopt(orphans_[i]);
+                }
+                orphans_.clear();
+            }
+
+            void initTrees () {
+                tree_.assign(vertexNumber_, FREE);
+                parent_.assign(vertexNumber_, static_cast<unsigned char>(NO_PARENT));
+                timestamp_.assign(vertexNumber_, 0);
+                distance_.assign(vertexNumber_, 0);
+                nextActive_.assign(vertexNumber_, static_cast<TVertex>(NO_VERTEX));
+                firstActive_ = lastActive_ = NO_VERTEX;
+                for (TVertex vertex = static_cast<TVertex>(0); vertex < vertexNumber_; ++vertex) {
+                    TTree terminalTree = getTerminalTree(vertex);
+                    if (terminalTree != FREE) {
+                        attachToTerminal(vertex, terminalTree);
+                    }
+                }
+                initialized_ = true;
+            }
+
+            // A marked vertex whose terminal link no longer holds it becomes an orphan, a free one joins the tree
+            // of its terminal link, everything marked is activated to look for the new paths.
+            void reuseTrees () {
+                ++time_;
+                for (size_t i = 0; i < marked_.size(); ++i) {
+                    TVertex vertex = marked_[i];
+                    TTree terminalTree = getTerminalTree(vertex);
+                    if (tree_[vertex] == FREE) {
+                        if (terminalTree != FREE) {
+                            attachToTerminal(vertex, terminalTree);
+                        }
+                        continue;
+                    }
+                    if (parent_[vertex] != ORPHAN && terminalTree != tree_[vertex] && (parent_[vertex] == TERMINAL || terminalTree != FREE)) {
+                        makeOrphan(vertex);
+                    }
+                    setActive(vertex);
+                }
+                marked_.clear();
+                adoptOrphans();
+            }
+
+        public:
+            BasicBoykovKolmogorov (BasicGridNetwork<TCapacity>& grid): grid_(grid), vertexNumber_(grid.getVertexNumber()),
+                                                                      directionNumber_(grid.getDirectionNumber()), initialized_(false), time_(0) {}
+
+            void markVertex (TVertex vertex) {
+                if (vertex < 0 || vertex >= vertexNumber_) {
+                    throw InvalidVertex();
+                }
+                if (initialized_) {
+                    marked_.push_back(vertex);
+                }
+            }
+
+            TFlow getMaxFlow () {
+                if (!initialized_) {
+                    initTrees();
+                } else {
+                    reuseTrees();
+                }
+                TVertex current = NO_VERTEX;
+                while (true) {
+                    if (current == NO_VERTEX || tree_[current] == FREE) {
+                        current = popActive();
+                        if (current == NO_VERTEX) {
+                            break;
+                        }
+                        if (tree_[current] == FREE) {
+                            current = NO_VERTEX;
+                            continue;
+                        }
+                    }
+                    int direction = grow(current);
+                    if (direction == -1) {
+                        current = NO_VERTEX;
+                        continue;
+                    }
+                    ++time_;
+                    if (tree_[current] == SOURCE_TREE) {
+                        augment(current, direction);
+                    } else {
+                        TVertex start = grid_.getNeighbour(current, direction);
+                        augment(start, direction ^ 1);
+                    }
+                    adoptOrphans();
+                }
+                return grid_.getFlow();
+            }
+
+            // The source side is the source tree. The cut arcs are the grid arcs and terminal links between the sides,
+            // their original capacities are not stored, so edges stays empty and value is the maximum flow.
+            MinCut getMinCut () {
+                MinCut cut;
+                cut.value = grid_.getFlow();
+                cut.sourceSide.resize(vertexNumber_);
+                for (TVertex vertex = static_cast<TVertex>(0); vertex < vertexNumber_; ++vertex) {
+                    cut.sourceSide[vertex] = tree_[vertex] == SOURCE_TREE;
+                }
+                return cut;
+            }
+
+            Statistics getStatistics () const {
+                return statistics_;
+            }
+        };
+
+        typedef BasicBoykovKolmogorov<TFlow> BoykovKolmogorov;
+    }
+}
+#endif
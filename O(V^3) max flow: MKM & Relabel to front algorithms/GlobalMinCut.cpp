@@ -0,0 +1,500 @@
+#include <thread>
+#include <random>
+#include <cmath>
+#include <limits>
+#include "src.cpp"
+
+#ifndef _GLOBAL_MIN_CUT_
+#define _GLOBAL_MIN_CUT_
+
+namespace NFlow {
+    namespace NInner {
+
+        // Undirected view of a network: every edge pair edge, edge ^ 1 (as added by Network::addEdge) is one
+        // undirected edge with the capacity of its first edge. The source and the sink play no role.
+        struct UndirectedEdge {
+            int start, finish;
+            TFlow weight;
+            int edge;
+        };
+
+        inline std::vector<UndirectedEdge> getUndirectedEdges (Network& network) {
+            std::vector<UndirectedEdge> edges;
+            for (int edgeIndex = 0; edgeIndex < network.getEdgeNumber(); edgeIndex += 2) {
+                Network::EdgeIterator edge = network.getEdge(edgeIndex);
+                if (edge.getStart() != edge.getFinish() && edge.getCapacity() > static_cast<TFlow>(0)) {
+                    UndirectedEdge undirected = {static_cast<int>(edge.getStart()), static_cast<int>(edge.getFinish()), edge.getCapacity(), edgeIndex};
+                    edges.push_back(undirected);
+                }
+            }
+            return edges;
+        }
+
+        // The cut edges are the first edges of the pairs joining the two sides.
+        inline MinCut makeGlobalCut (const std::vector<UndirectedEdge>& edges, std::vector<bool>&& side) {
+            MinCut cut;
+            cut.value = static_cast<TFlow>(0);
+            for (size_t i = 0; i < edges.size(); ++i) {
+                if (side[edges[i].start] != side[edges[i].finish]) {
+                    cut.value += edges[i].weight;
+                    cut.edges.push_back(edges[i].edge);
+                }
+            }
+            cut.sourceSide = std::move(side);
+            return cut;
+        }
+
+        // Max-priority queue over small integer keys which only grow while it is not empty: a list per key and a pointer to the top list.
+        class BucketQueue {
+        private:
+            std::vector<int> head_;
+            std::vector<int> next_, previous_;
+            std::vector<TFlow> key_;
+            TFlow top_;
+            int size_;
+
+            void link (int item) {
+                previous_[item] = -1;
+                next_[item] = head_[key_[item]];
+                if (next_[item] != -1) {
+                    previous_[next_[item]] = item;
+                }
+                head_[key_[item]] = item;
+                top_ = std::max(top_, key_[item]);
+            }
+
+            void unlink (int item) {
+                if (previous_[item] != -1) {
+                    next_[previous_[item]] = next_[item];
+                } else {
+                    head_[key_[item]] = next_[item];
+                }
+                if (next_[item] != -1) {
+                    previous_[next_[item]] = previous_[item];
+                }
+            }
+
+        public:
+            BucketQueue (size_t itemNumber, TFlow maxKey): head_(maxKey + 1, -1), next_(itemNumber), previous_(itemNumber),
+                                                           key_(itemNumber), top_(0), size_(0) {}
+
+            bool empty () const {
+                return size_ == 0;
+            }
+
+            void insert (int item, TFlow key) {
+                key_[item] = key;
+                link(item);
+                ++size_;
+            }
+
+            void increaseKey (int item, TFlow delta) {
+                unlink(item);
+                key_[item] += delta;
+                link(item);
+            }
+
+            TFlow getKey (int item) const {
+                return key_[item];
+            }
+
+            int popMax () {
+                while (head_[top_] == -1) {
+                    --top_;
+                }
+                int item = head_[top_];
+                unlink(item);
+                --size_;
+                // Every list is empty again, so the next phase starts scanning from key 0 instead of the old top.
+                if (size_ == 0) {
+                    top_ = 0;
+                }
+                return item;
+            }
+        };
+
+        // Stoer-Wagner: V - 1 maximum adjacency orderings, the last two vertices of each are merged.
+        // Merged vertices are kept as member lists with a union-find over the original adjacency, so a phase costs O(E)
+        // plus the priority queue: a BucketQueue when the total weight is small (e.g. unit capacities), IndexedHeap otherwise.
+        class StoerWagner {
+        private:
+            Network& network_;
+            int vertexNumber_;
+            std::vector<UndirectedEdge> edges_;
+            std::vector<int> arcBegin_;
+            std::vector<int> arcHead_;
+            std::vector<TFlow> arcWeight_;
+            std::vector<int> parent_;
+            std::vector<int> nextMember_, lastMember_;
+            TFlow totalWeight_;
+
+            static const int BUCKET_WEIGHT_FACTOR = 16;
+
+            int find (int curVertex) {
+                while (parent_[curVertex] != curVertex) {
+                    parent_[curVertex] = parent_[parent_[curVertex]];
+                    curVertex = parent_[curVertex];
+                }
+                return curVertex;
+            }
+
+            void merge (int into, int from) {
+                parent_[from] = into;
+                nextMember_[lastMember_[into]] = from;
+                lastMember_[into] = lastMember_[from];
+            }
+
+            // One maximum adjacency ordering over the groups; returns the cut of the phase and sets last and previous.
+            template <class TQueue>
+            TFlow phase (TQueue& queue, std::vector<int>& ordered, int stamp, int& last, int& previous) {
+                TFlow lastKey = static_cast<TFlow>(0);
+                last = previous = -1;
+                while (!queue.empty()) {
+                    int group = pop(queue);
+                    ordered[group] = stamp;
+                    previous = last;
+                    last = group;
+                    lastKey = getKey(queue, group);
+                    for (int member = group; member != -1; member = nextMember_[member]) {
+                        for (int arc = arcBegin_[member]; arc < arcBegin_[member + 1]; ++arc) {
+                            int neighbour = find(arcHead_[arc]);
+                            if (neighbour != group && ordered[neighbour] != stamp) {
+                                increase(queue, neighbour, arcWeight_[arc]);
+                            }
+                        }
+                    }
+                }
+                return lastKey;
+            }
+
+            static int pop (BucketQueue& queue) {
+                return queue.popMax();
+            }
+
+            static TFlow getKey (BucketQueue& queue, int item) {
+                return queue.getKey(item);
+            }
+
+            static void increase (BucketQueue& queue, int item, TFlow delta) {
+                queue.increaseKey(item, delta);
+            }
+
+            static int pop (IndexedHeap<TFlow>& queue) {
+                return queue.pop();
+            }
+
+            static TFlow getKey (IndexedHeap<TFlow>& queue, int item) {
+                return -queue.getKey(item);
+            }
+
+            static void increase (IndexedHeap<TFlow>& queue, int item, TFlow delta) {
+                queue.setKey(item, queue.getKey(item) - delta);
+            }
+
+            static void insert (BucketQueue& queue, int item) {
+                queue.insert(item, static_cast<TFlow>(0));
+            }
+
+            static void insert (IndexedHeap<TFlow>& queue, int item) {
+                queue.setKey(item, static_cast<TFlow>(0));
+            }
+
+            template <class TQueue>
+            MinCut run (TQueue& queue) {
+                std::vector<int> active(vertexNumber_);
+                std::vector<int> ordered(vertexNumber_, -1);
+                for (int curVertex = 0; curVertex < vertexNumber_; ++curVertex) {
+                    active[curVertex] = curVertex;
+                }
+                TFlow best = std::numeric_limits<TFlow>::max();
+                std::vector<bool> bestSide(vertexNumber_, false);
+                for (int stamp = 0; active.size() > 1; ++stamp) {
+                    for (size_t i = 0; i < active.size(); ++i) {
+                        insert(queue, active[i]);
+                    }
+                    int last, previous;
+                    TFlow cut = phase(queue, ordered, stamp, last, previous);
+                    if (cut < best) {
+                        best = cut;
+                        std::fill(bestSide.begin(), bestSide.end(), false);
+                        for (int member = last; member != -1; member = nextMember_[member]) {
+                            bestSide[member] = true;
+                        }
+                    }
+                    merge(previous, last);
+                    active.erase(std::find(active.begin(), active.end(), last));
+                }
+                return makeGlobalCut(edges_, std::move(bestSide));
+            }
+
+        public:
+            StoerWagner (Network& network): network_(network), vertexNumber_(network.getVertexNumber()), edges_(getUndirectedEdges(network)),
+                                            arcBegin_(vertexNumber_ + 1, 0), totalWeight_(0) {
+                for (size_t i = 0; i < edges_.size(); ++i) {
+                    ++arcBegin_[edges_[i].start + 1];
+                    ++arcBegin_[edges_[i].finish + 1];
+                    totalWeight_ += edges_[i].weight;
+                }
+                for (int curVertex = 0; curVertex < vertexNumber_; ++curVertex) {
+                    arcBegin_[curVertex + 1] += arcBegin_[curVertex];
+                }
+                arcHead_.resize(arcBegin_[vertexNumber_]);
+                arcWeight_.resize(arcBegin_[vertexNumber_]);
+                std::vector<int> position(arcBegin_.begin(), arcBegin_.end() - 1);
+                for (size_t i = 0; i < edges_.size(); ++i) {
+                    arcHead_[position[edges_[i].start]] = edges_[i].finish;
+                    arcWeight_[position[edges_[i].start]++] = edges_[i].weight;
+                    arcHead_[position[edges_[i].finish]] = edges_[i].start;
+                    arcWeight_[position[edges_[i].finish]++] = edges_[i].weight;
+                }
+            }
+
+            // sourceSide marks one side of a minimum cut over all pairs of vertices.
+            MinCut getMinCut () {
+                parent_.resize(vertexNumber_);
+                nextMember_.assign(vertexNumber_, -1);
+                lastMember_.resize(vertexNumber_);
+                for (int curVertex = 0; curVertex < vertexNumber_; ++curVertex) {
+                    parent_[curVertex] = lastMember_[curVertex] = curVertex;
+                }
+                if (totalWeight_ <= BUCKET_WEIGHT_FACTOR * (static_cast<TFlow>(vertexNumber_) + static_cast<TFlow>(edges_.size()))) {
+                    BucketQueue queue(vertexNumber_, totalWeight_);
+                    return run(queue);
+                }
+                IndexedHeap<TFlow> queue(vertexNumber_);
+                return run(queue);
+            }
+        };
+
+        // Karger-Stein recursive contraction: contract to V / sqrt(2) + 1 vertices twice independently and recurse,
+        // small graphs are cut exactly. An edge is contracted with probability proportional to its weight
+        // (random exponential keys). A trial finds a minimum cut with probability Omega(1 / log V), the trials are
+        // independent and run on threadNumber threads, each with its own generator.
+        class KargerStein {
+        private:
+            struct Edge {
+                int start, finish;
+                TFlow weight;
+            };
+
+            struct TrialResult {
+                TFlow value;
+                std::vector<int> side;
+            };
+
+            Network& network_;
+            int vertexNumber_;
+            std::vector<UndirectedEdge> edges_;
+            size_t trials_;
+            size_t threadNumber_;
+            unsigned seed_;
+
+            static const int EXACT_SIZE = 24;
+
+            static int find (std::vector<int>& parent, int curVertex) {
+                while (parent[curVertex] != curVertex) {
+                    parent[curVertex] = parent[parent[curVertex]];
+                    curVertex = parent[curVertex];
+                }
+                return curVertex;
+            }
+
+            // Contracts the graph on vertexNumber vertices to target ones, label maps the old vertices to the new ones.
+            static std::vector<Edge> contract (const std::vector<Edge>& edges, int vertexNumber, int target, std::mt19937_64& generator,
+                                               std::vector<int>& label) {
+                std::vector<std::pair<double, int> > order(edges.size());
+                std::uniform_real_distribution<double> uniform(0.0, 1.0);
+                for (size_t i = 0; i < edges.size(); ++i) {
+                    order[i] = std::make_pair(-std::log(1.0 - uniform(generator)) / edges[i].weight, static_cast<int>(i));
+                }
+                std::sort(order.begin(), order.end());
+                std::vector<int> parent(vertexNumber);
+                for (int curVertex = 0; curVertex < vertexNumber; ++curVertex) {
+                    parent[curVertex] = curVertex;
+                }
+                int components = vertexNumber;
+                for (size_t i = 0; i < order.size() && components > target; ++i) {
+                    const Edge& edge = edges[order[i].second];
+                    int start = find(parent, edge.start), finish = find(parent, edge.finish);
+                    if (start != finish) {
+                        parent[start] = finish;
+                        --components;
+                    }
+                }
+                label.assign(vertexNumber, -1);
+                int labelNumber = 0;
+                for (int curVertex = 0; curVertex < vertexNumber; ++curVertex) {
+                    int root = find(parent, curVertex);
+                    if (label[root] == -1) {
+                        label[root] = labelNumber++;
+                    }
+                    label[curVertex] = label[root];
+                }
+                std::vector<Edge> contracted;
+                for (size_t i = 0; i < edges.size(); ++i) {
+                    Edge edge = {label[edges[i].start], label[edges[i].finish], edges[i].weight};
+                    if (edge.start != edge.finish) {
+                        if (edge.start > edge.finish) {
+                            std::swap(edge.start, edge.finish);
+                        }
+                        contracted.push_back(edge);
+                    }
+                }
+                std::sort(contracted.begin(), contracted.end(), [] (const Edge& a, const Edge& b) {
+                    return a.start < b.start || (a.start == b.start && a.finish < b.finish);
+                });
+                std::vector<Edge> merged;
+                for (size_t i = 0; i < contracted.size(); ++i) {
+                    if (!merged.empty() && merged.back().start == contracted[i].start && merged.back().finish == contracted[i].finish) {
+                        merged.back().weight += contracted[i].weight;
+                    } else {
+                        merged.push_back(contracted[i]);
+                    }
+                }
+                return merged;
+            }
+
+            // Dense Stoer-Wagner in O(V^3) for the small graphs at the bottom of the recursion;
+            // side is indexed by the vertices of this graph.
+            static TFlow exact (const std::vector<Edge>& edges, int vertexNumber, std::vector<int>& side) {
+                std::vector<std::vector<TFlow> > weight(vertexNumber, std::vector<TFlow>(vertexNumber, static_cast<TFlow>(0)));
+                for (size_t i = 0; i < edges.size(); ++i) {
+                    weight[edges[i].start][edges[i].finish] += edges[i].weight;
+                    weight[edges[i].finish][edges[i].start] += edges[i].weight;
+                }
+                std::vector<int> group(vertexNumber), active(vertexNumber);
+                for (int curVertex = 0; curVertex < vertexNumber; ++curVertex) {
+                    group[curVertex] = active[curVertex] = curVertex;
+                }
+                TFlow best = std::numeric_limits<TFlow>::max();
+                side.assign(vertexNumber, 0);
+                std::vector<TFlow> key(vertexNumber);
+                std::vector<bool> added(vertexNumber);
+                while (active.size() > 1) {
+                    for (size_t i = 0; i < active.size(); ++i) {
+                        key[active[i]] = static_cast<TFlow>(0);
+                        added[active[i]] = false;
+                    }
+                    int previous = -1, last = -1;
+                    for (size_t step = 0; step < active.size(); ++step) {
+                        int next = -1;
+                        for (size_t i = 0; i < active.size(); ++i) {
+                            if (!added[active[i]] && (next == -1 || key[active[i]] > key[next])) {
+                                next = active[i];
+                            }
+                        }
+                        added[next] = true;
+                        previous = last;
+                        last = next;
+                        for (size_t i = 0; i < active.size(); ++i) {
+                            key[active[i]] += weight[next][active[i]];
+                        }
+                    }
+                    if (key[last] < best) {
+                        best = key[last];
+                        for (int curVertex = 0; curVertex < vertexNumber; ++curVertex) {
+                            side[curVertex] = group[curVertex] == last;
+                        }
+                    }
+                    for (size_t i = 0; i < active.size(); ++i) {
+                        weight[previous][active[i]] += weight[last][active[i]];
+                        weight[active[i]][previous] = weight[previous][active[i]];
+                    }
+                    weight[previous][previous] = static_cast<TFlow>(0);
+                    for (int curVertex = 0; curVertex < vertexNumber; ++curVertex) {
+                        if (group[curVertex] == last) {
+                            group[curVertex] = previous;
+                        }
+                    }
+                    active.erase(std::find(active.begin(), active.end(), last));
+                }
+                return best;
+            }
+
+            // side is indexed by the vertices of this graph.
+            static TFlow recurse (const std::vector<Edge>& edges, int vertexNumber, std::mt19937_64& generator, std::vector<int>& side) {
+                if (vertexNumber <= EXACT_SIZE) {
+                    return exact(edges, vertexNumber, side);
+                }
+                int target = static_cast<int>(std::ceil(1.0 + vertexNumber / std::sqrt(2.0)));
+                TFlow best = std::numeric_limits<TFlow>::max();
+                std::vector<int> label, innerSide;
+                for (int branch = 0; branch < 2; ++branch) {
+                    std::vector<Edge> contracted = contract(edges, vertexNumber, target, generator, label);
+                    int contractedNumber = *std::max_element(label.begin(), label.end()) + 1;
+                    TFlow value;
+                    if (contractedNumber > target) {
+                        // All edges are contracted, so the labels are the connected components.
+                        value = static_cast<TFlow>(0);
+                        innerSide.assign(contractedNumber, 0);
+                        innerSide[0] = 1;
+                    } else {
+                        value = recurse(contracted, contractedNumber, generator, innerSide);
+                    }
+                    if (value < best) {
+                        best = value;
+                        side.resize(vertexNumber);
+                        for (int curVertex = 0; curVertex < vertexNumber; ++curVertex) {
+                            side[curVertex] = innerSide[label[curVertex]];
+                        }
+                    }
+                }
+                return best;
+            }
+
+            void runTrials (size_t first, size_t step, TrialResult& result) const {
+                std::vector<Edge> edges;
+                for (size_t i = 0; i < edges_.size(); ++i) {
+                    Edge edge = {edges_[i].start, edges_[i].finish, edges_[i].weight};
+                    edges.push_back(edge);
+                }
+                result.value = std::numeric_limits<TFlow>::max();
+                std::vector<int> side;
+                for (size_t trial = first; trial < trials_; trial += step) {
+                    std::mt19937_64 generator(seed_ + trial);
+                    TFlow value = recurse(edges, vertexNumber_, generator, side);
+                    if (value < result.value) {
+                        result.value = value;
+                        result.side = side;
+                    }
+                }
+            }
+
+        public:
+            // trials == 0 picks ceil(log2 V)^2 trials, which makes a miss unlikely.
+            KargerStein (Network& network, size_t trials = 0, size_t threadNumber = 1, unsigned seed = 1):
+                    network_(network), vertexNumber_(network.getVertexNumber()), edges_(getUndirectedEdges(network)),
+                    trials_(trials), threadNumber_(std::max(threadNumber, static_cast<size_t>(1))), seed_(seed) {
+                if (trials_ == 0) {
+                    size_t log = static_cast<size_t>(std::ceil(std::log2(static_cast<double>(std::max(vertexNumber_, 2)))));
+                    trials_ = log * log;
+                }
+            }
+
+            // The smallest cut over all trials, a minimum cut with high probability.
+            MinCut getMinCut () {
+                std::vector<TrialResult> results(threadNumber_);
+                std::vector<std::thread> workers;
+                for (size_t thread = 1; thread < threadNumber_; ++thread) {
+                    workers.emplace_back(&KargerStein::runTrials, this, thread, threadNumber_, std::ref(results[thread]));
+                }
+                runTrials(0, threadNumber_, results[0]);
+                for (size_t thread = 0; thread < workers.size(); ++thread) {
+                    workers[thread].join();
+                }
+                size_t best = 0;
+                for (size_t thread = 1; thread < threadNumber_; ++thread) {
+                    if (results[thread].value < results[best].value) {
+                        best = thread;
+                    }
+                }
+                std::vector<bool> side(vertexNumber_);
+                for (int curVertex = 0; curVertex < vertexNumber_; ++curVertex) {
+                    side[curVertex] = results[best].side[curVertex] != 0;
+                }
+                return makeGlobalCut(edges_, std::move(side));
+            }
+        };
+    }
+}
+#endif
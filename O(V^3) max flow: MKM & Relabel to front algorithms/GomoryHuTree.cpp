@@ -0,0 +1,190 @@
+#include <limits>
+#include <thread>
+#include <memory>
+#include "src.cpp"
+
+#ifndef _GOMORY_HU_TREE_
+#define _GOMORY_HU_TREE_
+
+namespace NFlow {
+    namespace NInner {
+
+        // Gomory-Hu tree of an undirected network (edges added with Network::addEdge) built by Gusfield's algorithm:
+        // V - 1 maximum flows between a vertex and its current tree parent on the same network with the flow reset
+        // in between, no contraction is needed. The minimum cut between any two vertices is the lightest tree edge
+        // on the path between them, found with binary lifting in O(log V).
+        // With threadNumber > 1 consecutive flows run speculatively on thread-local copies of the network, a result
+        // is kept only if the parent it was computed for did not change meanwhile, otherwise it is recomputed.
+        // The network is left with its own source and sink and without flow.
+        template <class TAlgorithm>
+        class BasicGomoryHuTree {
+        private:
+            struct CutResult {
+                TVertex sink;
+                TFlow value;
+                std::vector<bool> sourceSide;
+            };
+
+            Network& network_;
+            TVertex vertexNumber_;
+            size_t threadNumber_;
+            std::vector<TVertex> parent_;
+            std::vector<TFlow> parentCut_;
+
+            int logNumber_;
+            std::vector<int> depth_;
+            std::vector<std::vector<TVertex> > ancestor_;
+            std::vector<std::vector<TFlow> > lightest_;
+
+            static void solve (Network& network, TVertex source, TVertex sink, CutResult& result) {
+                network.resetFlow();
+                network.setTerminals(source, sink);
+                TAlgorithm algorithm(network);
+                result.sink = sink;
+                result.value = algorithm.getMaxFlow();
+                result.sourceSide = algorithm.getMinCut().sourceSide;
+            }
+
+            // Gusfield's update: the vertices after source on its side of the cut hang from source from now on.
+            void apply (TVertex source, const CutResult& result) {
+                parentCut_[source] = result.value;
+                for (TVertex curVertex = source + 1; curVertex < vertexNumber_; ++curVertex) {
+                    if (result.sourceSide[curVertex] && parent_[curVertex] == result.sink) {
+                        parent_[curVertex] = source;
+                    }
+                }
+            }
+
+            void buildSequential () {
+                CutResult result;
+                for (TVertex curVertex = static_cast<TVertex>(1); curVertex < vertexNumber_; ++curVertex) {
+                    solve(network_, curVertex, parent_[curVertex], result);
+                    apply(curVertex, result);
+                }
+            }
+
+            void buildParallel () {
+                std::vector<std::unique_ptr<Network> > copies;
+                for (size_t thread = 0; thread < threadNumber_; ++thread) {
+                    copies.emplace_back(new Network(network_));
+                    copies.back()->resetFlow();
+                }
+                std::vector<CutResult> results(threadNumber_);
+                TVertex next = static_cast<TVertex>(1);
+                while (next < vertexNumber_) {
+                    size_t batch = std::min(static_cast<TVertex>(threadNumber_), vertexNumber_ - next);
+                    std::vector<std::thread> workers;
+                    for (size_t thread = 1; thread < batch; ++thread) {
+                        workers.emplace_back(solve, std::ref(*copies[thread]), next + thread, parent_[next + thread], std::ref(results[thread]));
+                    }
+                    solve(*copies[0], next, parent_[next], results[0]);
+                    for (size_t thread = 0; thread < workers.size(); ++thread) {
+                        workers[thread].join();
+                    }
+                    size_t thread = 0;
+                    while (thread < batch && results[thread].sink == parent_[next]) {
+                        apply(next, results[thread]);
+                        ++next;
+                        ++thread;
+                    }
+                }
+            }
+
+            void buildLifting () {
+                logNumber_ = 1;
+                while ((static_cast<TVertex>(1) << logNumber_) < vertexNumber_) {
+                    ++logNumber_;
+                }
+                std::vector<std::vector<TVertex> > children(vertexNumber_);
+                for (TVertex curVertex = static_cast<TVertex>(1); curVertex < vertexNumber_; ++curVertex) {
+                    children[parent_[curVertex]].push_back(curVertex);
+                }
+                depth_.assign(vertexNumber_, 0);
+                ancestor_.assign(logNumber_, std::vector<TVertex>(vertexNumber_, 0));
+                lightest_.assign(logNumber_, std::vector<TFlow>(vertexNumber_, static_cast<TFlow>(0)));
+                std::vector<TVertex> order(1, static_cast<TVertex>(0));
+                for (size_t i = 0; i < order.size(); ++i) {
+                    TVertex curVertex = order[i];
+                    for (size_t j = 0; j < children[curVertex].size(); ++j) {
+                        TVertex child = children[curVertex][j];
+                        depth_[child] = depth_[curVertex] + 1;
+                        ancestor_[0][child] = curVertex;
+                        lightest_[0][child] = parentCut_[child];
+                        order.push_back(child);
+                    }
+                }
+                for (int level = 1; level < logNumber_; ++level) {
+                    for (size_t i = 0; i < order.size(); ++i) {
+                        TVertex curVertex = order[i];
+                        TVertex middle = ancestor_[level - 1][curVertex];
+                        ancestor_[level][curVertex] = ancestor_[level - 1][middle];
+                        lightest_[level][curVertex] = std::min(lightest_[level - 1][curVertex], lightest_[level - 1][middle]);
+                    }
+                }
+            }
+
+        public:
+            BasicGomoryHuTree (Network& network, size_t threadNumber = 1): network_(network), vertexNumber_(network.getVertexNumber()),
+                                                                           threadNumber_(std::max(threadNumber, static_cast<size_t>(1))),
+                                                                           parent_(vertexNumber_, 0), parentCut_(vertexNumber_, static_cast<TFlow>(0)) {
+                TVertex source = network.getSource(), sink = network.getSink();
+                if (threadNumber_ == 1) {
+                    buildSequential();
+                } else {
+                    buildParallel();
+                }
+                network.resetFlow();
+                network.setTerminals(source, sink);
+                buildLifting();
+            }
+
+            // The root 0 is its own parent.
+            TVertex getParent (TVertex curVertex) const {
+                if (curVertex < static_cast<TVertex>(0) || curVertex >= vertexNumber_) {
+                    throw InvalidVertex();
+                }
+                return parent_[curVertex];
+            }
+
+            TFlow getParentCutValue (TVertex curVertex) const {
+                if (curVertex < static_cast<TVertex>(0) || curVertex >= vertexNumber_) {
+                    throw InvalidVertex();
+                }
+                return parentCut_[curVertex];
+            }
+
+            TFlow getMinCutValue (TVertex first, TVertex second) const {
+                if (first < static_cast<TVertex>(0) || first >= vertexNumber_ || second < static_cast<TVertex>(0) || second >= vertexNumber_) {
+                    throw InvalidVertex();
+                }
+                if (first == second) {
+                    throw SourceIsEqualToSinkException();
+                }
+                if (depth_[first] < depth_[second]) {
+                    std::swap(first, second);
+                }
+                TFlow result = std::numeric_limits<TFlow>::max();
+                for (int level = logNumber_ - 1; level >= 0; --level) {
+                    if (depth_[first] - (1 << level) >= depth_[second]) {
+                        result = std::min(result, lightest_[level][first]);
+                        first = ancestor_[level][first];
+                    }
+                }
+                if (first == second) {
+                    return result;
+                }
+                for (int level = logNumber_ - 1; level >= 0; --level) {
+                    if (ancestor_[level][first] != ancestor_[level][second]) {
+                        result = std::min(result, std::min(lightest_[level][first], lightest_[level][second]));
+                        first = ancestor_[level][first];
+                        second = ancestor_[level][second];
+                    }
+                }
+                return std::min(result, std::min(lightest_[0][first], lightest_[0][second]));
+            }
+        };
+
+        typedef BasicGomoryHuTree<MalCumMah> GomoryHuTree;
+    }
+}
+#endif
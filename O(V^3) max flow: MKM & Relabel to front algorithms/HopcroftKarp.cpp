@@ -0,0 +1,320 @@
+#include <memory>
+#include "src.cpp"
+
+#ifndef _HOPCROFT_KARP_
+#define _HOPCROFT_KARP_
+
+namespace NFlow {
+    namespace NInner {
+
+        // Left to right adjacency in compressed rows, no reversed edges are stored.
+        class BipartiteGraph {
+        private:
+            int leftNumber_, rightNumber_;
+            std::vector<int> begin_;
+            std::vector<int> neighbours_;
+
+        public:
+            // edges are (left, right) pairs, they are bucketed by the left end with a counting sort.
+            BipartiteGraph (int leftNumber, int rightNumber, const std::vector<std::pair<int, int> >& edges):
+                    leftNumber_(leftNumber), rightNumber_(rightNumber), begin_(leftNumber + 1, 0), neighbours_(edges.size()) {
+                for (size_t i = 0; i < edges.size(); ++i) {
+                    if (edges[i].first < 0 || edges[i].first >= leftNumber || edges[i].second < 0 || edges[i].second >= rightNumber) {
+                        throw InvalidVertex();
+                    }
+                    ++begin_[edges[i].first + 1];
+                }
+                for (int left = 0; left < leftNumber; ++left) {
+                    begin_[left + 1] += begin_[left];
+                }
+                std::vector<int> position(begin_.begin(), begin_.end() - 1);
+                for (size_t i = 0; i < edges.size(); ++i) {
+                    neighbours_[position[edges[i].first]++] = edges[i].second;
+                }
+            }
+
+            int getLeftNumber () const {
+                return leftNumber_;
+            }
+
+            int getRightNumber () const {
+                return rightNumber_;
+            }
+
+            int getBegin (int left) const {
+                return begin_[left];
+            }
+
+            int getEnd (int left) const {
+                return begin_[left + 1];
+            }
+
+            int getNeighbour (int position) const {
+                return neighbours_[position];
+            }
+        };
+
+        // Maximum matching in O(E sqrt(V)): BFS layers from the free left vertices up to the first layer that
+        // reaches a free right vertex, then vertex disjoint shortest augmenting paths found by an iterative DFS
+        // over the layers. Every phase lengthens the shortest augmenting path, so there are O(sqrt(V)) phases.
+        class HopcroftKarp {
+        private:
+            const BipartiteGraph& graph_;
+            std::vector<int> matchLeft_;
+            std::vector<int> matchRight_;
+            std::vector<int> distance_;
+            int freeDistance_;
+            int phaseNumber_;
+            std::vector<int> ptr_;
+            std::vector<bool> reachedRight_;
+            std::vector<int> stack_;
+
+            bool bfs () {
+                std::queue<int> leftQ;
+                freeDistance_ = INF;
+                reachedRight_.assign(graph_.getRightNumber(), false);
+                for (int left = 0; left < graph_.getLeftNumber(); ++left) {
+                    if (matchLeft_[left] == -1) {
+                        distance_[left] = 0;
+                        leftQ.push(left);
+                    } else {
+                        distance_[left] = INF;
+                    }
+                }
+                while (!leftQ.empty()) {
+                    int left = leftQ.front();
+                    leftQ.pop();
+                    if (distance_[left] > freeDistance_) {
+                        break;
+                    }
+                    for (int position = graph_.getBegin(left); position < graph_.getEnd(left); ++position) {
+                        int right = graph_.getNeighbour(position);
+                        reachedRight_[right] = true;
+                        int next = matchRight_[right];
+                        if (next == -1) {
+                            freeDistance_ = std::min(freeDistance_, distance_[left]);
+                        } else if (distance_[next] == INF && distance_[left] < freeDistance_) {
+                            distance_[next] = distance_[left] + 1;
+                            leftQ.push(next);
+                        }
+                    }
+                }
+                return freeDistance_ != INF;
+            }
+
+            bool augment (int root) {
+                stack_.assign(1, root);
+                while (!stack_.empty()) {
+                    int left = stack_.back();
+                    if (ptr_[left] == graph_.getEnd(left)) {
+                        distance_[left] = INF;
+                        stack_.pop_back();
+                        if (!stack_.empty()) {
+                            ++ptr_[stack_.back()];
+                        }
+                        continue;
+                    }
+                    int right = graph_.getNeighbour(ptr_[left]);
+                    int next = matchRight_[right];
+                    if (next == -1 && distance_[left] == freeDistance_) {
+                        for (size_t i = 0; i < stack_.size(); ++i) {
+                            int pathLeft = stack_[i];
+                            int pathRight = graph_.getNeighbour(ptr_[pathLeft]);
+                            matchLeft_[pathLeft] = pathRight;
+                            matchRight_[pathRight] = pathLeft;
+                        }
+                        return true;
+                    }
+                    if (next != -1 && distance_[next] == distance_[left] + 1) {
+                        stack_.push_back(next);
+                    } else {
+                        ++ptr_[left];
+                    }
+                }
+                return false;
+            }
+
+        public:
+            HopcroftKarp (const BipartiteGraph& graph): graph_(graph), matchLeft_(graph.getLeftNumber(), -1), matchRight_(graph.getRightNumber(), -1),
+                                                        distance_(graph.getLeftNumber(), INF), freeDistance_(INF), phaseNumber_(0),
+                                                        ptr_(graph.getLeftNumber(), 0) {}
+
+            int getMaxMatching () {
+                int matching = 0;
+                while (bfs()) {
+                    ++phaseNumber_;
+                    for (int left = 0; left < graph_.getLeftNumber(); ++left) {
+                        ptr_[left] = graph_.getBegin(left);
+                    }
+                    for (int left = 0; left < graph_.getLeftNumber(); ++left) {
+                        if (matchLeft_[left] == -1 && augment(left)) {
+                            ++matching;
+                        }
+                    }
+                }
+                return matching;
+            }
+
+            int getPhaseNumber () const {
+                return phaseNumber_;
+            }
+
+            int getMatchLeft (int left) const {
+                return matchLeft_[left];
+            }
+
+            int getMatchRight (int right) const {
+                return matchRight_[right];
+            }
+
+            // After getMaxMatching the last BFS marks the vertices reachable by alternating paths from the free left vertices.
+            bool isLeftReached (int left) const {
+                return distance_[left] != INF;
+            }
+
+            bool isRightReached (int right) const {
+                return reachedRight_[right];
+            }
+        };
+
+        // Recognises networks of the form source -> left -> right -> sink with unit capacities and zero flow
+        // and solves them with HopcroftKarp on a compact BipartiteGraph, any other network goes to MalCumMah.
+        class BipartiteMatchingAdapter: public Algorithm {
+        private:
+            Network& network_;
+            TVertex vertexNumber_;
+            TVertex source_, sink_;
+            bool bipartite_;
+            std::unique_ptr<Algorithm> fallback_;
+
+            std::vector<int> compactIndex_;
+            std::vector<TVertex> leftVertices_, rightVertices_;
+            std::vector<int> sourceEdge_, sinkEdge_;
+            std::unique_ptr<BipartiteGraph> graph_;
+            std::unique_ptr<HopcroftKarp> matcher_;
+            Statistics statistics_;
+
+            enum TSide {NONE, LEFT, RIGHT};
+
+            bool detect () {
+                std::vector<TSide> side(vertexNumber_, NONE);
+                compactIndex_.assign(vertexNumber_, -1);
+                for (Network::EdgeIterator edge = network_.getEdgeListBegin(source_); edge.isValid(); edge.next()) {
+                    if (edge.getCapacity() == static_cast<TFlow>(0)) {
+                        continue;
+                    }
+                    TVertex left = edge.getFinish();
+                    if (edge.getCapacity() != static_cast<TFlow>(1) || left == sink_ || side[left] != NONE) {
+                        return false;
+                    }
+                    side[left] = LEFT;
+                    compactIndex_[left] = leftVertices_.size();
+                    leftVertices_.push_back(left);
+                    sourceEdge_.push_back(edge.getIndex());
+                }
+                for (Network::EdgeIterator edge = network_.getEdgeListBegin(sink_); edge.isValid(); edge.next()) {
+                    if (edge.getReversedResCap() == static_cast<TFlow>(0) && edge.getCapacity() == static_cast<TFlow>(0)) {
+                        continue;
+                    }
+                    TVertex right = edge.getFinish();
+                    if (edge.getCapacity() != static_cast<TFlow>(0) || edge.getReversedResCap() != static_cast<TFlow>(1) || side[right] != NONE) {
+                        return false;
+                    }
+                    side[right] = RIGHT;
+                    compactIndex_[right] = rightVertices_.size();
+                    rightVertices_.push_back(right);
+                    sinkEdge_.push_back(edge.getIndex() ^ 1);
+                }
+                std::vector<std::pair<int, int> > edges;
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    for (Network::EdgeIterator edge = network_.getEdgeListBegin(curVertex); edge.isValid(); edge.next()) {
+                        if (edge.getFlow() != static_cast<TFlow>(0)) {
+                            return false;
+                        }
+                        if (edge.getCapacity() == static_cast<TFlow>(0) || curVertex == source_ || edge.getFinish() == sink_) {
+                            continue;
+                        }
+                        if (side[curVertex] != LEFT || side[edge.getFinish()] != RIGHT || edge.getCapacity() != static_cast<TFlow>(1)) {
+                            return false;
+                        }
+                        edges.push_back(std::make_pair(compactIndex_[curVertex], compactIndex_[edge.getFinish()]));
+                    }
+                }
+                graph_.reset(new BipartiteGraph(leftVertices_.size(), rightVertices_.size(), edges));
+                return true;
+            }
+
+            void writeFlow () {
+                std::vector<int> matchedRight(leftVertices_.size(), -1);
+                for (size_t left = 0; left < leftVertices_.size(); ++left) {
+                    int right = matcher_->getMatchLeft(left);
+                    if (right == -1) {
+                        continue;
+                    }
+                    Network::EdgeIterator sourceEdge = network_.getEdge(sourceEdge_[left]);
+                    sourceEdge.changeFlow(1);
+                    sourceEdge.changeReversedFlow(-1);
+                    Network::EdgeIterator sinkEdge = network_.getEdge(sinkEdge_[right]);
+                    sinkEdge.changeFlow(1);
+                    sinkEdge.changeReversedFlow(-1);
+                    for (Network::EdgeIterator edge = network_.getEdgeListBegin(leftVertices_[left]); edge.isValid(); edge.next()) {
+                        if (edge.getCapacity() > static_cast<TFlow>(0) && edge.getFinish() == rightVertices_[right]) {
+                            edge.changeFlow(1);
+                            edge.changeReversedFlow(-1);
+                            break;
+                        }
+                    }
+                }
+            }
+
+        public:
+            BipartiteMatchingAdapter (Network& network): network_(network), vertexNumber_(network.getVertexNumber()),
+                                                         source_(network.getSource()), sink_(network.getSink()) {
+                bipartite_ = detect();
+                if (!bipartite_) {
+                    leftVertices_.clear();
+                    rightVertices_.clear();
+                    sourceEdge_.clear();
+                    sinkEdge_.clear();
+                    fallback_.reset(new MalCumMah(network));
+                }
+            }
+
+            bool isBipartite () const {
+                return bipartite_;
+            }
+
+            TFlow getMaxFlow () {
+                if (!bipartite_) {
+                    return fallback_->getMaxFlow();
+                }
+                matcher_.reset(new HopcroftKarp(*graph_));
+                statistics_.augmentations = matcher_->getMaxMatching();
+                statistics_.phases = matcher_->getPhaseNumber();
+                writeFlow();
+                return network_.getFlow();
+            }
+
+            // Koenig: the source side is the source with the vertices reached by alternating paths from the free left vertices.
+            MinCut getMinCut () {
+                if (!bipartite_) {
+                    return fallback_->getMinCut();
+                }
+                std::vector<bool> sourceSide(vertexNumber_, false);
+                sourceSide[source_] = true;
+                for (size_t left = 0; left < leftVertices_.size(); ++left) {
+                    sourceSide[leftVertices_[left]] = matcher_->isLeftReached(left);
+                }
+                for (size_t right = 0; right < rightVertices_.size(); ++right) {
+                    sourceSide[rightVertices_[right]] = matcher_->isRightReached(right);
+                }
+                return network_.getCut(std::move(sourceSide));
+            }
+
+            Statistics getStatistics () const {
+                return bipartite_ ? statistics_ : fallback_->getStatistics();
+            }
+        };
+    }
+}
+#endif
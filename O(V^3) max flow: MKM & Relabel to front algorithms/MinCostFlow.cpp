@@ -0,0 +1,298 @@
+#include <limits>
+#include <cstdlib>
+#include "ParallelPushRelabel.cpp"
+
+typedef long long TCost;
+
+#ifndef _MIN_COST_FLOW_
+#define _MIN_COST_FLOW_
+
+namespace NFlow {
+    namespace NInner {
+
+        struct NegativeCycleException : public std::exception {};
+
+        enum TMinCostFlowMode {SUCCESSIVE_SHORTEST_PATHS, COST_SCALING};
+
+        // Minimum cost maximum flow. The costs live here, not in the Network: costs[edgeIndex] is the cost of a unit
+        // of flow along that edge, so an addEdge pair gets its cost at both indices, while the entry of the reversed
+        // edge of an addOrEdge pair is never used, that edge has no capacity of its own.
+        // Pushing along an edge first cancels the flow of its reversed edge, refunding that edge's cost,
+        // and only then pays its own; a pair whose two costs sum below zero is a negative cycle.
+        // SUCCESSIVE_SHORTEST_PATHS augments along Dijkstra shortest paths with Johnson potentials,
+        // COST_SCALING finds any maximum flow with ParallelPushRelabel on threadNumber threads (only the calling one
+        // by default) and then cancels its negative cycles with Goldberg's cost scaling push-relabel.
+        // Successive shortest paths throws NegativeCycleException on a negative cycle reachable from the source,
+        // cost scaling cancels such cycles as part of the minimum cost circulation.
+        class MinCostFlow: public Algorithm {
+        private:
+            Network& network_;
+            TVertex vertexNumber_;
+            TVertex source_, sink_;
+            TMinCostFlowMode mode_;
+            size_t threadNumber_;
+            std::vector<TCost> costs_;
+            std::vector<TCost> potential_;
+            std::vector<TCost> distance_;
+            std::vector<int> parentEdge_;
+            IndexedHeap<TCost> heap_;
+            MinCut cut_;
+            Statistics statistics_;
+
+            std::vector<TFlow> excess_;
+            std::vector<bool> inQueue_;
+            std::vector<Network::EdgeIterator> ptr_;
+
+            static const int SCALING_FACTOR = 8;
+
+            const TCost COST_INF = std::numeric_limits<TCost>::max() / 4;
+
+            TCost getEdgeCost (const Network::EdgeIterator& edge) const {
+                return edge.getFlow() < static_cast<TFlow>(0) ? -costs_[edge.getIndex() ^ 1] : costs_[edge.getIndex()];
+            }
+
+            // The residual capacity up to the point where the cost of pushing along the edge changes.
+            TFlow getSegmentCapacity (const Network::EdgeIterator& edge) const {
+                return edge.getFlow() < static_cast<TFlow>(0) ? -edge.getFlow() : edge.getResidualCapacity();
+            }
+
+            TCost reducedCost (Network::EdgeIterator edge) const {
+                return getEdgeCost(edge) + potential_[edge.getStart()] - potential_[edge.getFinish()];
+            }
+
+            // Bellman-Ford (queue based) potentials, needed only when some residual edge has a negative cost.
+            void initPotentials () {
+                bool negativeEdge = false;
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_ && !negativeEdge; ++curVertex) {
+                    for (Network::EdgeIterator edge = network_.getEdgeListBegin(curVertex); edge.isValid(); edge.next()) {
+                        if (getSegmentCapacity(edge) > static_cast<TFlow>(0) && getEdgeCost(edge) < static_cast<TCost>(0)) {
+                            negativeEdge = true;
+                            break;
+                        }
+                    }
+                }
+                potential_.assign(vertexNumber_, static_cast<TCost>(0));
+                if (!negativeEdge) {
+                    return;
+                }
+                std::vector<TCost> distance(vertexNumber_, COST_INF);
+                std::vector<int> relaxations(vertexNumber_, 0);
+                std::vector<bool> inQueue(vertexNumber_, false);
+                std::queue<TVertex> vertexIndexQ;
+                distance[source_] = static_cast<TCost>(0);
+                vertexIndexQ.push(source_);
+                while (!vertexIndexQ.empty()) {
+                    TVertex curVertex = vertexIndexQ.front();
+                    vertexIndexQ.pop();
+                    inQueue[curVertex] = false;
+                    if (++relaxations[curVertex] > vertexNumber_) {
+                        throw NegativeCycleException();
+                    }
+                    for (Network::EdgeIterator edge = network_.getEdgeListBegin(curVertex); edge.isValid(); edge.next()) {
+                        if (getSegmentCapacity(edge) > static_cast<TFlow>(0) && distance[curVertex] + getEdgeCost(edge) < distance[edge.getFinish()]) {
+                            distance[edge.getFinish()] = distance[curVertex] + getEdgeCost(edge);
+                            if (!inQueue[edge.getFinish()]) {
+                                inQueue[edge.getFinish()] = true;
+                                vertexIndexQ.push(edge.getFinish());
+                            }
+                        }
+                    }
+                }
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    if (distance[curVertex] != COST_INF) {
+                        potential_[curVertex] = distance[curVertex];
+                    }
+                }
+            }
+
+            // Vertices the search does not reach stay unreachable from the source for the rest of the run,
+            // so their potentials are never looked at again.
+            bool dijkstra () {
+                distance_.assign(vertexNumber_, COST_INF);
+                distance_[source_] = static_cast<TCost>(0);
+                heap_.setKey(source_, static_cast<TCost>(0));
+                while (!heap_.empty()) {
+                    TVertex curVertex = heap_.pop();
+                    for (Network::EdgeIterator edge = network_.getEdgeListBegin(curVertex); edge.isValid(); edge.next()) {
+                        if (getSegmentCapacity(edge) <= static_cast<TFlow>(0)) {
+                            continue;
+                        }
+                        TCost newDistance = distance_[curVertex] + reducedCost(edge);
+                        if (newDistance < distance_[edge.getFinish()]) {
+                            distance_[edge.getFinish()] = newDistance;
+                            parentEdge_[edge.getFinish()] = edge.getIndex();
+                            heap_.setKey(edge.getFinish(), newDistance);
+                        }
+                    }
+                }
+                if (distance_[sink_] == COST_INF) {
+                    return false;
+                }
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    if (distance_[curVertex] != COST_INF) {
+                        potential_[curVertex] += distance_[curVertex];
+                    }
+                }
+                return true;
+            }
+
+            void augment () {
+                TFlow change = std::numeric_limits<TFlow>::max();
+                for (TVertex curVertex = sink_; curVertex != source_; ) {
+                    Network::EdgeIterator edge = network_.getEdge(parentEdge_[curVertex]);
+                    change = std::min(change, getSegmentCapacity(edge));
+                    curVertex = edge.getStart();
+                }
+                for (TVertex curVertex = sink_; curVertex != source_; ) {
+                    Network::EdgeIterator edge = network_.getEdge(parentEdge_[curVertex]);
+                    edge.changeFlow(change);
+                    edge.changeReversedFlow(-change);
+                    curVertex = edge.getStart();
+                }
+                ++statistics_.augmentations;
+            }
+
+            // Prices live in the costs multiplied by V + 1, so 1-optimality there means optimality of the original costs.
+            TCost scaledReducedCost (Network::EdgeIterator edge) const {
+                return getEdgeCost(edge) * (vertexNumber_ + 1) + potential_[edge.getStart()] - potential_[edge.getFinish()];
+            }
+
+            void pushScaling (Network::EdgeIterator edge, TFlow change) {
+                edge.changeFlow(change);
+                edge.changeReversedFlow(-change);
+                excess_[edge.getStart()] -= change;
+                excess_[edge.getFinish()] += change;
+                ++statistics_.pushes;
+            }
+
+            void relabelScaling (TVertex curVertex, TCost epsilon) {
+                TCost maxPrice = -COST_INF;
+                for (Network::EdgeIterator edge = network_.getEdgeListBegin(curVertex); edge.isValid(); edge.next()) {
+                    if (getSegmentCapacity(edge) > static_cast<TFlow>(0)) {
+                        maxPrice = std::max(maxPrice, potential_[edge.getFinish()] - getEdgeCost(edge) * (vertexNumber_ + 1));
+                    }
+                }
+                potential_[curVertex] = maxPrice - epsilon;
+                ++statistics_.relabels;
+            }
+
+            void refine (TCost epsilon) {
+                std::queue<TVertex> activeVertices;
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    for (Network::EdgeIterator edge = network_.getEdgeListBegin(curVertex); edge.isValid(); edge.next()) {
+                        while (getSegmentCapacity(edge) > static_cast<TFlow>(0) && scaledReducedCost(edge) < static_cast<TCost>(0)) {
+                            pushScaling(edge, getSegmentCapacity(edge));
+                        }
+                    }
+                }
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    ptr_[curVertex] = network_.getEdgeListBegin(curVertex);
+                    inQueue_[curVertex] = excess_[curVertex] > static_cast<TFlow>(0);
+                    if (inQueue_[curVertex]) {
+                        activeVertices.push(curVertex);
+                    }
+                }
+                while (!activeVertices.empty()) {
+                    TVertex curVertex = activeVertices.front();
+                    activeVertices.pop();
+                    inQueue_[curVertex] = false;
+                    while (excess_[curVertex] > static_cast<TFlow>(0)) {
+                        if (!ptr_[curVertex].isValid()) {
+                            relabelScaling(curVertex, epsilon);
+                            ptr_[curVertex] = network_.getEdgeListBegin(curVertex);
+                            continue;
+                        }
+                        Network::EdgeIterator edge = ptr_[curVertex];
+                        if (getSegmentCapacity(edge) > static_cast<TFlow>(0) && scaledReducedCost(edge) < static_cast<TCost>(0)) {
+                            pushScaling(edge, std::min(getSegmentCapacity(edge), excess_[curVertex]));
+                            if (excess_[edge.getFinish()] > static_cast<TFlow>(0) && !inQueue_[edge.getFinish()]) {
+                                inQueue_[edge.getFinish()] = true;
+                                activeVertices.push(edge.getFinish());
+                            }
+                        } else {
+                            ptr_[curVertex].next();
+                        }
+                    }
+                }
+            }
+
+            void costScaling () {
+                TCost epsilon = static_cast<TCost>(0);
+                for (int edgeIndex = 0; edgeIndex < network_.getEdgeNumber(); ++edgeIndex) {
+                    if (network_.getEdge(edgeIndex).getCapacity() > static_cast<TFlow>(0)) {
+                        epsilon = std::max(epsilon, std::abs(costs_[edgeIndex]) * (vertexNumber_ + 1));
+                    }
+                }
+                potential_.assign(vertexNumber_, static_cast<TCost>(0));
+                excess_.assign(vertexNumber_, static_cast<TFlow>(0));
+                inQueue_.assign(vertexNumber_, false);
+                ptr_.clear();
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    ptr_.push_back(network_.getEdgeListBegin(curVertex));
+                }
+                while (epsilon > static_cast<TCost>(1)) {
+                    epsilon = std::max(static_cast<TCost>(1), epsilon / SCALING_FACTOR);
+                    refine(epsilon);
+                }
+            }
+
+        public:
+            MinCostFlow (Network& network, const std::vector<TCost>& costs, TMinCostFlowMode mode = SUCCESSIVE_SHORTEST_PATHS,
+                         size_t threadNumber = 1):
+                    network_(network), vertexNumber_(network.getVertexNumber()), source_(network.getSource()), sink_(network.getSink()),
+                    mode_(mode), threadNumber_(threadNumber), costs_(costs), parentEdge_(vertexNumber_, -1), heap_(vertexNumber_) {
+                if (static_cast<int>(costs_.size()) != network.getEdgeNumber()) {
+                    throw InvalidEdge();
+                }
+                for (int edgeIndex = 0; edgeIndex < network.getEdgeNumber(); edgeIndex += 2) {
+                    if (network.getEdge(edgeIndex).getCapacity() > static_cast<TFlow>(0) && network.getEdge(edgeIndex ^ 1).getCapacity() > static_cast<TFlow>(0)
+                        && costs_[edgeIndex] + costs_[edgeIndex ^ 1] < static_cast<TCost>(0)) {
+                        throw NegativeCycleException();
+                    }
+                }
+            }
+
+            TFlow getMaxFlow () {
+                if (mode_ == COST_SCALING) {
+                    ParallelPushRelabel maxFlow(network_, threadNumber_);
+                    maxFlow.getMaxFlow();
+                    cut_ = maxFlow.getMinCut();
+                    costScaling();
+                    return network_.getFlow();
+                }
+                initPotentials();
+                while (dijkstra()) {
+                    augment();
+                }
+                std::vector<bool> sourceSide(vertexNumber_);
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    sourceSide[curVertex] = distance_[curVertex] != COST_INF;
+                }
+                cut_ = network_.getCut(std::move(sourceSide));
+                return network_.getFlow();
+            }
+
+            // Cost of the current flow of the network.
+            TCost getCost () {
+                TCost curCost = static_cast<TCost>(0);
+                for (int edgeIndex = 0; edgeIndex < network_.getEdgeNumber(); ++edgeIndex) {
+                    TFlow flow = network_.getEdge(edgeIndex).getFlow();
+                    if (flow > static_cast<TFlow>(0)) {
+                        curCost += flow * costs_[edgeIndex];
+                    }
+                }
+                return curCost;
+            }
+
+            // Every maximum flow saturates every minimum cut, so the cut survives the cost optimisation.
+            MinCut getMinCut () {
+                return cut_;
+            }
+
+            Statistics getStatistics () const {
+                return statistics_;
+            }
+        };
+    }
+}
+#endif
@@ -0,0 +1,333 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <memory>
+#include <limits>
+#include "src.cpp"
+
+#ifndef _NETWORK_IO_
+#define _NETWORK_IO_
+
+namespace NFlow {
+    namespace NInner {
+
+        struct FileOpenException : public std::exception {};
+
+        struct InvalidInputFormat : public std::exception {};
+
+        struct FileWriteException : public std::exception {};
+
+        // DIMACS "p max / n / a" text input and a native binary format holding the raw Network arrays.
+        class NetworkIO {
+        private:
+            class BufferedReader {
+            private:
+                std::FILE* file_;
+                std::vector<char> buffer_;
+                size_t size_, position_;
+
+                static const size_t BUFFER_SIZE = 1 << 22;
+
+            public:
+                BufferedReader (std::FILE* file): file_(file), buffer_(BUFFER_SIZE), size_(0), position_(0) {}
+
+                int peek () {
+                    if (position_ == size_) {
+                        size_ = std::fread(buffer_.data(), 1, buffer_.size(), file_);
+                        position_ = 0;
+                        if (size_ == 0) {
+                            return EOF;
+                        }
+                    }
+                    return buffer_[position_];
+                }
+
+                int get () {
+                    int symbol = peek();
+                    if (symbol != EOF) {
+                        ++position_;
+                    }
+                    return symbol;
+                }
+
+                void skipLine () {
+                    int symbol = get();
+                    while (symbol != EOF && symbol != '\n') {
+                        symbol = get();
+                    }
+                }
+
+                void skipBlanks () {
+                    while (peek() == ' ' || peek() == '\t' || peek() == '\r') {
+                        get();
+                    }
+                }
+
+                long long readInteger () {
+                    skipBlanks();
+                    bool negative = false;
+                    if (peek() == '-') {
+                        negative = true;
+                        get();
+                    }
+                    if (peek() < '0' || peek() > '9') {
+                        throw InvalidInputFormat();
+                    }
+                    long long value = 0;
+                    while (peek() >= '0' && peek() <= '9') {
+                        value = value * 10 + (get() - '0');
+                    }
+                    return negative ? -value : value;
+                }
+
+                std::string readWord () {
+                    skipBlanks();
+                    std::string word;
+                    while (peek() != EOF && peek() != ' ' && peek() != '\t' && peek() != '\r' && peek() != '\n') {
+                        word.push_back(get());
+                    }
+                    return word;
+                }
+            };
+
+            struct BinaryHeader {
+                char magic[8];
+                long long vertexNumber, source, sink, edgeNumber;
+            };
+
+            static void fillMagic (char* magic) {
+                std::memcpy(magic, "NFLOWBN2", 8);
+            }
+
+            // Closes the file on every path out of the reading and writing functions.
+            class File {
+            private:
+                std::FILE* file_;
+
+            public:
+                File (const std::string& path, const char* mode): file_(std::fopen(path.c_str(), mode)) {
+                    if (file_ == nullptr) {
+                        throw FileOpenException();
+                    }
+                }
+
+                ~File () {
+                    if (file_ != nullptr) {
+                        std::fclose(file_);
+                    }
+                }
+
+                File (const File&) = delete;
+
+                File& operator = (const File&) = delete;
+
+                std::FILE* get () const {
+                    return file_;
+                }
+
+                // Returns false if the buffered data could not be written.
+                bool close () {
+                    int result = std::fclose(file_);
+                    file_ = nullptr;
+                    return result == 0;
+                }
+            };
+
+            template <class T>
+            static void readArray (std::FILE* file, std::vector<T>& array) {
+                if (std::fread(array.data(), sizeof(T), array.size(), file) != array.size()) {
+                    throw InvalidInputFormat();
+                }
+            }
+
+            template <class T>
+            static void writeArray (std::FILE* file, const std::vector<T>& array) {
+                if (std::fwrite(array.data(), sizeof(T), array.size(), file) != array.size()) {
+                    throw FileWriteException();
+                }
+            }
+
+            // Bytes left in the file after the current position, -1 if the file can not be measured.
+            static long long remainingBytes (std::FILE* file) {
+                long position = std::ftell(file);
+                if (position < 0 || std::fseek(file, 0, SEEK_END) != 0) {
+                    return -1;
+                }
+                long end = std::ftell(file);
+                if (end < 0 || std::fseek(file, position, SEEK_SET) != 0) {
+                    return -1;
+                }
+                return end - position;
+            }
+
+            // The arrays read from a file must form the adjacency lists of a network: every edge lies in the list
+            // of its start exactly once, the lists end with -1, and edge ^ 1 is the reversed edge.
+            // The stored flow must be feasible too, since the solvers resume from it.
+            static void validate (const Network& network) {
+                int edgeNumber = network.edges_.size();
+                std::vector<TFlow> excess(network.vertexNumber_, static_cast<TFlow>(0));
+                for (int edgeIndex = 0; edgeIndex < edgeNumber; ++edgeIndex) {
+                    const Edge& edge = network.edges_[edgeIndex];
+                    const Edge& reversed = network.edges_[edgeIndex ^ 1];
+                    if (edge.start < 0 || edge.start >= network.vertexNumber_ || edge.finish < 0
+                        || edge.finish >= network.vertexNumber_ || edge.start != reversed.finish || edge.finish != reversed.start
+                        || network.ptr_[edgeIndex] < -1 || network.ptr_[edgeIndex] >= edgeNumber) {
+                        throw InvalidInputFormat();
+                    }
+                    if (edge.cap < static_cast<TFlow>(0) || reversed.cap < static_cast<TFlow>(0) || edge.flow > edge.cap
+                        || edge.flow < -reversed.cap || reversed.flow != -edge.flow) {
+                        throw InvalidInputFormat();
+                    }
+                    excess[edge.finish] += edge.flow;
+                }
+                for (TVertex curVertex = 0; curVertex < network.vertexNumber_; ++curVertex) {
+                    if (curVertex != network.source_ && curVertex != network.sink_ && excess[curVertex] != static_cast<TFlow>(0)) {
+                        throw InvalidInputFormat();
+                    }
+                }
+                std::vector<bool> listed(edgeNumber, false);
+                int listedNumber = 0;
+                for (TVertex curVertex = 0; curVertex < network.vertexNumber_; ++curVertex) {
+                    int edgeIndex = network.lasts_[curVertex];
+                    if (edgeIndex < -1 || edgeIndex >= edgeNumber) {
+                        throw InvalidInputFormat();
+                    }
+                    for (; edgeIndex != -1; edgeIndex = network.ptr_[edgeIndex]) {
+                        if (listed[edgeIndex] || network.edges_[edgeIndex].start != curVertex) {
+                            throw InvalidInputFormat();
+                        }
+                        listed[edgeIndex] = true;
+                        ++listedNumber;
+                    }
+                }
+                if (listedNumber != edgeNumber) {
+                    throw InvalidInputFormat();
+                }
+            }
+
+            static Network parseDimacs (BufferedReader& reader) {
+                TVertex vertexNumber = -1, source = -1, sink = -1;
+                long long arcNumber = 0;
+                std::unique_ptr<Network> network;
+                while (true) {
+                    int symbol = reader.get();
+                    if (symbol == EOF) {
+                        break;
+                    }
+                    if (symbol == 'p') {
+                        if (reader.readWord() != "max") {
+                            throw InvalidInputFormat();
+                        }
+                        vertexNumber = reader.readInteger();
+                        arcNumber = reader.readInteger();
+                        if (arcNumber < 0 || arcNumber > std::numeric_limits<int>::max() / 2) {
+                            throw InvalidInputFormat();
+                        }
+                    } else if (symbol == 'n') {
+                        TVertex vertex = reader.readInteger() - 1;
+                        std::string kind = reader.readWord();
+                        if (kind == "s") {
+                            source = vertex;
+                        } else if (kind == "t") {
+                            sink = vertex;
+                        } else {
+                            throw InvalidInputFormat();
+                        }
+                    } else if (symbol == 'a') {
+                        if (!network) {
+                            if (vertexNumber < 0 || source < 0 || sink < 0) {
+                                throw InvalidInputFormat();
+                            }
+                            network.reset(new Network(vertexNumber, source, sink));
+                            network->reserveEdges(static_cast<int>(2 * arcNumber));
+                        }
+                        TVertex start = reader.readInteger() - 1;
+                        TVertex finish = reader.readInteger() - 1;
+                        TFlow cap = reader.readInteger();
+                        if (start < 0 || start >= vertexNumber || finish < 0 || finish >= vertexNumber) {
+                            throw InvalidVertex();
+                        }
+                        network->addOrEdge(start, finish, cap);
+                    } else if (symbol != 'c' && symbol != '\n' && symbol != '\r') {
+                        throw InvalidInputFormat();
+                    }
+                    if (symbol != '\n') {
+                        reader.skipLine();
+                    }
+                }
+                if (!network) {
+                    if (vertexNumber < 0 || source < 0 || sink < 0) {
+                        throw InvalidInputFormat();
+                    }
+                    network.reset(new Network(vertexNumber, source, sink));
+                }
+                return std::move(*network);
+            }
+
+        public:
+            static Network readDimacs (std::FILE* file) {
+                BufferedReader reader(file);
+                return parseDimacs(reader);
+            }
+
+            static Network readDimacs (const std::string& path) {
+                File file(path, "rb");
+                BufferedReader reader(file.get());
+                return parseDimacs(reader);
+            }
+
+            // Header followed by the edge, next-edge and list-head arrays exactly as they are in memory,
+            // so the file is only portable between machines with the same endianness.
+            // Throws FileWriteException if any part of the file could not be written.
+            static void writeBinary (const Network& network, const std::string& path) {
+                File file(path, "wb");
+                BinaryHeader header;
+                fillMagic(header.magic);
+                header.vertexNumber = network.vertexNumber_;
+                header.source = network.source_;
+                header.sink = network.sink_;
+                header.edgeNumber = network.edges_.size();
+                if (std::fwrite(&header, sizeof(header), 1, file.get()) != 1) {
+                    throw FileWriteException();
+                }
+                writeArray(file.get(), network.edges_);
+                writeArray(file.get(), network.ptr_);
+                writeArray(file.get(), network.lasts_);
+                if (!file.close()) {
+                    throw FileWriteException();
+                }
+            }
+
+            // The header is checked against the file size before anything is allocated and every index read
+            // is validated, so a truncated or corrupt file throws InvalidInputFormat.
+            static Network readBinary (const std::string& path) {
+                File file(path, "rb");
+                BinaryHeader header;
+                char magic[8];
+                fillMagic(magic);
+                if (std::fread(&header, sizeof(header), 1, file.get()) != 1 || std::memcmp(header.magic, magic, 8) != 0) {
+                    throw InvalidInputFormat();
+                }
+                const long long maxIndex = std::numeric_limits<int>::max();
+                if (header.vertexNumber < 1 || header.vertexNumber > maxIndex || header.edgeNumber < 0 || header.edgeNumber > maxIndex
+                    || header.edgeNumber % 2 != 0) {
+                    throw InvalidInputFormat();
+                }
+                long long expectedBytes = header.edgeNumber * static_cast<long long>(sizeof(Edge) + sizeof(int))
+                                          + header.vertexNumber * static_cast<long long>(sizeof(int));
+                if (remainingBytes(file.get()) != expectedBytes) {
+                    throw InvalidInputFormat();
+                }
+                Network network(header.vertexNumber, header.source, header.sink);
+                network.edges_.resize(header.edgeNumber);
+                network.ptr_.resize(header.edgeNumber);
+                readArray(file.get(), network.edges_);
+                readArray(file.get(), network.ptr_);
+                readArray(file.get(), network.lasts_);
+                validate(network);
+                return network;
+            }
+        };
+    }
+}
+#endif
@@ -0,0 +1,231 @@
+#include <memory>
+#include "src.cpp"
+
+#ifndef _NETWORK_REDUCTION_
+#define _NETWORK_REDUCTION_
+
+namespace NFlow {
+    namespace NInner {
+
+        // Shrinks a network before a maximum flow without changing its value:
+        // vertices the source can not reach or which can not reach the sink are dropped, parallel edges
+        // are merged, dead ends are cut off and every vertex with two neighbours is contracted into an edge
+        // between them with the bottleneck capacities. The rest is renumbered into getReducedNetwork().
+        // Works on the residual capacities, so the network may already carry a flow; mapFlowBack adds
+        // the flow found on the reduced network to the original edges.
+        class NetworkReduction {
+        private:
+            enum TLinkType {ORIGINAL, SERIES, PARALLEL};
+
+            // A link joins start and finish with the capacity forward in one direction and backward in the other.
+            // An original link stands for the edge pair edge, edge ^ 1; series and parallel links for two other links.
+            struct Link {
+                TLinkType type;
+                TVertex start, finish;
+                TFlow forward, backward;
+                int edge;
+                int first, second;
+            };
+
+            Network& network_;
+            TVertex vertexNumber_;
+            TVertex source_, sink_;
+            std::vector<Link> links_;
+            std::vector<std::unordered_map<TVertex, int> > adjacent_;
+            std::vector<TVertex> reducedVertex_;
+            std::unique_ptr<Network> reduced_;
+            std::vector<int> topLinks_;
+            std::vector<int> forwardEdge_, backwardEdge_;
+
+            // Capacity of the link from the given end to the other one.
+            TFlow getCapacityFrom (int link, TVertex from) const {
+                return links_[link].start == from ? links_[link].forward : links_[link].backward;
+            }
+
+            int newLink (TLinkType type, TVertex start, TVertex finish, TFlow forward, TFlow backward, int first, int second) {
+                Link link = {type, start, finish, forward, backward, -1, first, second};
+                links_.push_back(link);
+                return links_.size() - 1;
+            }
+
+            // Puts the link into the adjacency, merging it with the link already joining the same vertices.
+            void insertLink (int link) {
+                TVertex start = links_[link].start, finish = links_[link].finish;
+                auto existing = adjacent_[start].find(finish);
+                if (existing != adjacent_[start].end()) {
+                    int other = existing->second;
+                    link = newLink(PARALLEL, start, finish, links_[link].forward + getCapacityFrom(other, start),
+                                   links_[link].backward + getCapacityFrom(other, finish), link, other);
+                }
+                if (links_[link].forward == static_cast<TFlow>(0) && links_[link].backward == static_cast<TFlow>(0)) {
+                    adjacent_[start].erase(finish);
+                    adjacent_[finish].erase(start);
+                    return;
+                }
+                adjacent_[start][finish] = link;
+                adjacent_[finish][start] = link;
+            }
+
+            std::vector<bool> reach (TVertex from, bool forward) {
+                std::vector<bool> reached(vertexNumber_, false);
+                std::vector<TVertex> stack(1, from);
+                reached[from] = true;
+                while (!stack.empty()) {
+                    TVertex curVertex = stack.back();
+                    stack.pop_back();
+                    for (Network::EdgeIterator edge = network_.getEdgeListBegin(curVertex); edge.isValid(); edge.next()) {
+                        TFlow cap = forward ? edge.getResidualCapacity() : edge.getReversedResCap();
+                        if (cap > static_cast<TFlow>(0) && !reached[edge.getFinish()]) {
+                            reached[edge.getFinish()] = true;
+                            stack.push_back(edge.getFinish());
+                        }
+                    }
+                }
+                return reached;
+            }
+
+            void collectLinks () {
+                std::vector<bool> fromSource = reach(source_, true);
+                std::vector<bool> toSink = reach(sink_, false);
+                for (int edgeIndex = 0; edgeIndex < network_.getEdgeNumber(); edgeIndex += 2) {
+                    Network::EdgeIterator edge = network_.getEdge(edgeIndex);
+                    TVertex start = edge.getStart(), finish = edge.getFinish();
+                    if (start == finish || !fromSource[start] || !toSink[start] || !fromSource[finish] || !toSink[finish]) {
+                        continue;
+                    }
+                    int link = newLink(ORIGINAL, start, finish, edge.getResidualCapacity(), edge.getReversedResCap(), -1, -1);
+                    links_[link].edge = edgeIndex;
+                    insertLink(link);
+                }
+            }
+
+            // A vertex other than the terminals with one neighbour carries no flow, with two it is a piece of a series chain.
+            void contract () {
+                std::vector<TVertex> candidates;
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    if (adjacent_[curVertex].size() <= 2) {
+                        candidates.push_back(curVertex);
+                    }
+                }
+                while (!candidates.empty()) {
+                    TVertex curVertex = candidates.back();
+                    candidates.pop_back();
+                    if (curVertex == source_ || curVertex == sink_ || adjacent_[curVertex].size() > 2 || adjacent_[curVertex].empty()) {
+                        continue;
+                    }
+                    if (adjacent_[curVertex].size() == 1) {
+                        TVertex neighbour = adjacent_[curVertex].begin()->first;
+                        adjacent_[curVertex].clear();
+                        adjacent_[neighbour].erase(curVertex);
+                        candidates.push_back(neighbour);
+                        continue;
+                    }
+                    auto it = adjacent_[curVertex].begin();
+                    TVertex start = it->first;
+                    int first = it->second;
+                    ++it;
+                    TVertex finish = it->first;
+                    int second = it->second;
+                    adjacent_[curVertex].clear();
+                    adjacent_[start].erase(curVertex);
+                    adjacent_[finish].erase(curVertex);
+                    TFlow forward = std::min(getCapacityFrom(first, start), getCapacityFrom(second, curVertex));
+                    TFlow backward = std::min(getCapacityFrom(second, finish), getCapacityFrom(first, curVertex));
+                    insertLink(newLink(SERIES, start, finish, forward, backward, first, second));
+                    candidates.push_back(start);
+                    candidates.push_back(finish);
+                }
+            }
+
+            void renumber () {
+                reducedVertex_.assign(vertexNumber_, -1);
+                TVertex reducedNumber = static_cast<TVertex>(0);
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    if (curVertex == source_ || curVertex == sink_ || !adjacent_[curVertex].empty()) {
+                        reducedVertex_[curVertex] = reducedNumber++;
+                    }
+                }
+                reduced_.reset(new Network(reducedNumber, reducedVertex_[source_], reducedVertex_[sink_]));
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    for (auto it = adjacent_[curVertex].begin(); it != adjacent_[curVertex].end(); ++it) {
+                        if (it->first < curVertex) {
+                            continue;
+                        }
+                        const Link& link = links_[it->second];
+                        topLinks_.push_back(it->second);
+                        forwardEdge_.push_back(-1);
+                        backwardEdge_.push_back(-1);
+                        if (link.forward > static_cast<TFlow>(0)) {
+                            forwardEdge_.back() = reduced_->addOrEdge(reducedVertex_[link.start], reducedVertex_[link.finish], link.forward);
+                        }
+                        if (link.backward > static_cast<TFlow>(0)) {
+                            backwardEdge_.back() = reduced_->addOrEdge(reducedVertex_[link.finish], reducedVertex_[link.start], link.backward);
+                        }
+                    }
+                }
+            }
+
+            // Splits the net flow from start to finish of the link down to the original edges.
+            void distribute (int topLink, TFlow flow) {
+                std::vector<std::pair<int, TFlow> > stack(1, std::make_pair(topLink, flow));
+                while (!stack.empty()) {
+                    int link = stack.back().first;
+                    flow = stack.back().second;
+                    stack.pop_back();
+                    const Link& cur = links_[link];
+                    if (cur.type == ORIGINAL) {
+                        Network::EdgeIterator edge = network_.getEdge(cur.edge);
+                        edge.changeFlow(flow);
+                        edge.changeReversedFlow(-flow);
+                    } else if (cur.type == SERIES) {
+                        stack.push_back(std::make_pair(cur.first, links_[cur.first].start == cur.start ? flow : -flow));
+                        stack.push_back(std::make_pair(cur.second, links_[cur.second].finish == cur.finish ? flow : -flow));
+                    } else {
+                        TFlow firstFlow = std::min(getCapacityFrom(cur.first, cur.start), std::max(-getCapacityFrom(cur.first, cur.finish),
+                                                                                                   flow - getCapacityFrom(cur.second, cur.start)));
+                        stack.push_back(std::make_pair(cur.first, links_[cur.first].start == cur.start ? firstFlow : -firstFlow));
+                        stack.push_back(std::make_pair(cur.second, links_[cur.second].start == cur.start ? flow - firstFlow : firstFlow - flow));
+                    }
+                }
+            }
+
+        public:
+            NetworkReduction (Network& network): network_(network), vertexNumber_(network.getVertexNumber()),
+                                                 source_(network.getSource()), sink_(network.getSink()), adjacent_(vertexNumber_) {
+                collectLinks();
+                contract();
+                renumber();
+                adjacent_.clear();
+                adjacent_.shrink_to_fit();
+            }
+
+            Network& getReducedNetwork () {
+                return *reduced_;
+            }
+
+            // -1 for the vertices removed by the reduction.
+            TVertex getReducedVertex (TVertex curVertex) const {
+                if (curVertex < static_cast<TVertex>(0) || curVertex >= vertexNumber_) {
+                    throw InvalidVertex();
+                }
+                return reducedVertex_[curVertex];
+            }
+
+            // Call once, after a solver has run on the reduced network. Returns the flow of the original network.
+            TFlow mapFlowBack () {
+                for (size_t i = 0; i < topLinks_.size(); ++i) {
+                    TFlow flow = static_cast<TFlow>(0);
+                    if (forwardEdge_[i] != -1) {
+                        flow += reduced_->getEdge(forwardEdge_[i]).getFlow();
+                    }
+                    if (backwardEdge_[i] != -1) {
+                        flow -= reduced_->getEdge(backwardEdge_[i]).getFlow();
+                    }
+                    distribute(topLinks_[i], flow);
+                }
+                return network_.getFlow();
+            }
+        };
+    }
+}
+#endif
@@ -0,0 +1,317 @@
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <algorithm>
+#include "src.cpp"
+
+#ifndef _PARALLEL_PUSH_RELABEL_
+#define _PARALLEL_PUSH_RELABEL_
+
+namespace NFlow {
+    namespace NInner {
+
+        // Lock-free push-relabel (Hong-He): every active vertex is owned by exactly one worker,
+        // it pushes to its lowest residual neighbour or relabels; residual capacities and excesses are atomics.
+        // Workers are periodically stopped for a parallel BFS global relabel (Baumstark-Blelloch-Shun).
+        class ParallelPushRelabel: public Algorithm {
+        private:
+            class Barrier {
+            private:
+                std::mutex mutex_;
+                std::condition_variable condition_;
+                size_t threadNumber_;
+                size_t waiting_;
+                size_t generation_;
+
+            public:
+                Barrier (size_t threadNumber): threadNumber_(threadNumber), waiting_(0), generation_(0) {}
+
+                void wait () {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    size_t generation = generation_;
+                    if (++waiting_ == threadNumber_) {
+                        waiting_ = 0;
+                        ++generation_;
+                        condition_.notify_all();
+                    } else {
+                        condition_.wait(lock, [&] { return generation != generation_; });
+                    }
+                }
+            };
+
+            struct WorkerQueue {
+                std::mutex mutex;
+                std::deque<TVertex> vertices;
+            };
+
+            Network& network_;
+            TVertex vertexNumber_;
+            TVertex source_, sink_;
+            size_t threadNumber_;
+            int unreachedHeight_;
+
+            std::vector<int> arcBegin_;
+            std::vector<TVertex> arcHead_;
+            std::vector<int> arcReversed_;
+            std::vector<std::atomic<TFlow> > residual_;
+            std::vector<std::atomic<TFlow> > excess_;
+            std::vector<std::atomic<int> > height_;
+            std::vector<std::atomic<bool> > queued_;
+
+            std::vector<std::unique_ptr<WorkerQueue> > queues_;
+            std::atomic<long long> pending_;
+            std::atomic<long long> work_;
+            std::atomic<bool> stop_;
+            std::atomic<long long> pushes_;
+            std::atomic<long long> relabels_;
+            long long workBudget_;
+
+            std::vector<TVertex> frontier_;
+            std::vector<std::vector<TVertex> > nextFrontier_;
+            std::atomic<size_t> frontierPosition_;
+
+            static const size_t FRONTIER_CHUNK = 64;
+
+            template <class TWorker>
+            void runParallel (TWorker worker) {
+                std::vector<std::thread> threads;
+                for (size_t threadIndex = 1; threadIndex < threadNumber_; ++threadIndex) {
+                    threads.push_back(std::thread(worker, threadIndex));
+                }
+                worker(0);
+                for (size_t i = 0; i < threads.size(); ++i) {
+                    threads[i].join();
+                }
+            }
+
+            void bfsWorker (size_t threadIndex, int baseHeight, Barrier& barrier) {
+                int level = baseHeight;
+                while (true) {
+                    std::vector<TVertex>& next = nextFrontier_[threadIndex];
+                    size_t begin;
+                    while ((begin = frontierPosition_.fetch_add(FRONTIER_CHUNK)) < frontier_.size()) {
+                        size_t end = std::min(begin + FRONTIER_CHUNK, frontier_.size());
+                        for (size_t i = begin; i < end; ++i) {
+                            TVertex curVertex = frontier_[i];
+                            for (int arc = arcBegin_[curVertex]; arc < arcBegin_[curVertex + 1]; ++arc) {
+                                TVertex neighbour = arcHead_[arc];
+                                if (residual_[arcReversed_[arc]].load(std::memory_order_relaxed) <= static_cast<TFlow>(0)) {
+                                    continue;
+                                }
+                                int expected = unreachedHeight_;
+                                if (height_[neighbour].compare_exchange_strong(expected, level + 1)) {
+                                    next.push_back(neighbour);
+                                }
+                            }
+                        }
+                    }
+                    barrier.wait();
+                    if (threadIndex == 0) {
+                        frontier_.clear();
+                        for (size_t i = 0; i < nextFrontier_.size(); ++i) {
+                            frontier_.insert(frontier_.end(), nextFrontier_[i].begin(), nextFrontier_[i].end());
+                            nextFrontier_[i].clear();
+                        }
+                        frontierPosition_ = 0;
+                    }
+                    barrier.wait();
+                    if (frontier_.empty()) {
+                        return;
+                    }
+                    ++level;
+                }
+            }
+
+            void bfsFrom (TVertex root, int baseHeight) {
+                frontier_.assign(1, root);
+                frontierPosition_ = 0;
+                Barrier barrier(threadNumber_);
+                runParallel([&] (size_t threadIndex) { bfsWorker(threadIndex, baseHeight, barrier); });
+            }
+
+            // Exact distances to the sink, vertices that can not reach it get distance to the source plus V.
+            void globalRelabel () {
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    height_[curVertex] = unreachedHeight_;
+                }
+                height_[sink_] = 0;
+                height_[source_] = vertexNumber_;
+                bfsFrom(sink_, 0);
+                bfsFrom(source_, vertexNumber_);
+            }
+
+            void enqueue (TVertex curVertex, size_t threadIndex) {
+                if (curVertex == source_ || curVertex == sink_ || queued_[curVertex].exchange(true)) {
+                    return;
+                }
+                ++pending_;
+                std::lock_guard<std::mutex> lock(queues_[threadIndex]->mutex);
+                queues_[threadIndex]->vertices.push_back(curVertex);
+            }
+
+            bool pop (size_t threadIndex, TVertex& curVertex) {
+                while (!stop_.load(std::memory_order_relaxed) && pending_.load() > 0) {
+                    for (size_t shift = 0; shift < threadNumber_; ++shift) {
+                        WorkerQueue& queue = *queues_[(threadIndex + shift) % threadNumber_];
+                        std::lock_guard<std::mutex> lock(queue.mutex);
+                        if (queue.vertices.empty()) {
+                            continue;
+                        }
+                        if (shift == 0) {
+                            curVertex = queue.vertices.back();
+                            queue.vertices.pop_back();
+                        } else {
+                            curVertex = queue.vertices.front();
+                            queue.vertices.pop_front();
+                        }
+                        return true;
+                    }
+                    std::this_thread::yield();
+                }
+                return false;
+            }
+
+            void discharge (TVertex curVertex, size_t threadIndex) {
+                long long pushes = 0, relabels = 0;
+                while (excess_[curVertex].load() > static_cast<TFlow>(0) && !stop_.load(std::memory_order_relaxed)) {
+                    TFlow excess = excess_[curVertex].load();
+                    int minHeight = INF;
+                    int bestArc = -1;
+                    for (int arc = arcBegin_[curVertex]; arc < arcBegin_[curVertex + 1]; ++arc) {
+                        if (residual_[arc].load(std::memory_order_relaxed) > static_cast<TFlow>(0)) {
+                            int neighbourHeight = height_[arcHead_[arc]].load(std::memory_order_relaxed);
+                            if (neighbourHeight < minHeight) {
+                                minHeight = neighbourHeight;
+                                bestArc = arc;
+                            }
+                        }
+                    }
+                    if (bestArc == -1) {
+                        break;
+                    }
+                    if (height_[curVertex].load() > minHeight) {
+                        TFlow residual = residual_[bestArc].load();
+                        TFlow delta = (excess < residual ? excess : residual);
+                        residual_[bestArc] -= delta;
+                        residual_[arcReversed_[bestArc]] += delta;
+                        excess_[curVertex] -= delta;
+                        excess_[arcHead_[bestArc]] += delta;
+                        enqueue(arcHead_[bestArc], threadIndex);
+                        ++pushes;
+                    } else {
+                        height_[curVertex] = minHeight + 1;
+                        ++relabels;
+                        if ((work_ += arcBegin_[curVertex + 1] - arcBegin_[curVertex] + 12) > workBudget_) {
+                            stop_ = true;
+                        }
+                    }
+                }
+                pushes_ += pushes;
+                relabels_ += relabels;
+            }
+
+            void dischargeWorker (size_t threadIndex) {
+                TVertex curVertex;
+                while (pop(threadIndex, curVertex)) {
+                    discharge(curVertex, threadIndex);
+                    queued_[curVertex] = false;
+                    if (excess_[curVertex].load() > static_cast<TFlow>(0)) {
+                        enqueue(curVertex, threadIndex);
+                    }
+                    --pending_;
+                }
+            }
+
+        public:
+            ParallelPushRelabel (Network& network, size_t threadNumber = std::thread::hardware_concurrency()):
+                    network_(network), vertexNumber_(network.getVertexNumber()), source_(network.getSource()), sink_(network.getSink()),
+                    threadNumber_(threadNumber == 0 ? 1 : threadNumber), unreachedHeight_(2 * vertexNumber_),
+                    arcBegin_(vertexNumber_ + 1, 0), arcHead_(network.getEdgeNumber()), arcReversed_(network.getEdgeNumber()),
+                    residual_(network.getEdgeNumber()), excess_(vertexNumber_), height_(vertexNumber_), queued_(vertexNumber_),
+                    pending_(0), work_(0), stop_(false), pushes_(0), relabels_(0), nextFrontier_(threadNumber_), frontierPosition_(0) {
+                workBudget_ = 6 * vertexNumber_ + network.getEdgeNumber() / 2;
+                for (size_t threadIndex = 0; threadIndex < threadNumber_; ++threadIndex) {
+                    queues_.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+                }
+
+                std::vector<int> position(network.getEdgeNumber());
+                int arc = 0;
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    arcBegin_[curVertex] = arc;
+                    excess_[curVertex] = static_cast<TFlow>(0);
+                    queued_[curVertex] = false;
+                    for (Network::EdgeIterator edge = network.getEdgeListBegin(curVertex); edge.isValid(); edge.next()) {
+                        position[edge.getIndex()] = arc;
+                        arcHead_[arc] = edge.getFinish();
+                        residual_[arc] = edge.getResidualCapacity();
+                        excess_[curVertex] -= edge.getFlow();
+                        ++arc;
+                    }
+                }
+                arcBegin_[vertexNumber_] = arc;
+                for (int edgeIndex = 0; edgeIndex < network.getEdgeNumber(); ++edgeIndex) {
+                    arcReversed_[position[edgeIndex]] = position[edgeIndex ^ 1];
+                }
+
+                for (arc = arcBegin_[source_]; arc < arcBegin_[source_ + 1]; ++arc) {
+                    TFlow delta = residual_[arc].load();
+                    residual_[arc] -= delta;
+                    residual_[arcReversed_[arc]] += delta;
+                    excess_[arcHead_[arc]] += delta;
+                }
+            }
+
+            TFlow getMaxFlow () {
+                while (true) {
+                    globalRelabel();
+                    pending_ = 0;
+                    work_ = 0;
+                    stop_ = false;
+                    for (size_t threadIndex = 0; threadIndex < threadNumber_; ++threadIndex) {
+                        queues_[threadIndex]->vertices.clear();
+                    }
+                    for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                        queued_[curVertex] = false;
+                    }
+                    for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                        if (excess_[curVertex].load() > static_cast<TFlow>(0)) {
+                            enqueue(curVertex, curVertex % threadNumber_);
+                        }
+                    }
+                    if (pending_.load() == 0) {
+                        break;
+                    }
+                    runParallel([&] (size_t threadIndex) { dischargeWorker(threadIndex); });
+                }
+
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    int arc = arcBegin_[curVertex];
+                    for (Network::EdgeIterator edge = network_.getEdgeListBegin(curVertex); edge.isValid(); edge.next(), ++arc) {
+                        edge.changeFlow(edge.getCapacity() - residual_[arc].load() - edge.getFlow());
+                    }
+                }
+                return network_.getFlow();
+            }
+
+            Statistics getStatistics () const {
+                Statistics statistics;
+                statistics.pushes = pushes_.load();
+                statistics.relabels = relabels_.load();
+                return statistics;
+            }
+
+            // The last global relabel found no active vertex, vertices that can not reach the sink got heights of at least V.
+            MinCut getMinCut () {
+                std::vector<bool> sourceSide(vertexNumber_);
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    sourceSide[curVertex] = height_[curVertex].load() >= vertexNumber_;
+                }
+                return network_.getCut(std::move(sourceSide));
+            }
+        };
+    }
+}
+#endif
@@ -0,0 +1,439 @@
+#include <functional>
+#include <memory>
+#include "src.cpp"
+
+#ifndef _PARAMETRIC_MAX_FLOW_
+#define _PARAMETRIC_MAX_FLOW_
+
+namespace NFlow {
+    namespace NInner {
+
+        struct NonMonotoneCapacityException : public std::exception {};
+
+        typedef std::function<TFlow (TFlow)> TCapacityFunction;
+
+        // Minimum cut at a parameter value; sourceSide is the largest source side among the minimum cuts.
+        struct ParametricCut {
+            TFlow lambda;
+            TFlow value;
+            std::vector<bool> sourceSide;
+        };
+
+        // An arc of a (possibly contracted) parametric network, function is -1 for a fixed capacity.
+        struct ParametricArc {
+            TVertex start, finish;
+            TFlow cap;
+            int function;
+        };
+
+        struct ParametricProblem {
+            TVertex vertexNumber, source, sink;
+            std::vector<ParametricArc> arcs;
+        };
+
+        // Gallo-Grigoriadis-Tarjan: push-relabel computing a maximum preflow whose state is kept between
+        // increasing values of lambda. The growing source arcs are saturated again, the flow over the shrinking
+        // sink arcs is cut back and left as excess, the labels stay valid, so the whole sequence costs about one
+        // push-relabel run plus O(E) per value. Heights are capped at V: such vertices can not reach the sink.
+        class ParametricPushRelabel {
+        private:
+            const std::vector<TCapacityFunction>& functions_;
+            TVertex vertexNumber_;
+            TVertex source_, sink_;
+            std::vector<int> arcBegin_;
+            std::vector<TVertex> arcHead_;
+            std::vector<int> arcReversed_;
+            std::vector<TFlow> residual_;
+            std::vector<int> parametricArc_;
+            std::vector<int> parametricFunction_;
+            std::vector<TFlow> parametricCap_;
+            std::vector<TFlow> excess_;
+            std::vector<int> height_;
+            std::vector<int> current_;
+            std::vector<int> heightQueue_;
+            std::queue<TVertex> active_;
+            bool started_;
+            TFlow lambda_;
+            long long workSinceRelabel_;
+
+            TVertex getArcStart (int arc) const {
+                return arcHead_[arcReversed_[arc]];
+            }
+
+            void pushArc (int arc, TFlow change) {
+                residual_[arc] -= change;
+                residual_[arcReversed_[arc]] += change;
+                excess_[getArcStart(arc)] -= change;
+                excess_[arcHead_[arc]] += change;
+            }
+
+            void activate (TVertex curVertex) {
+                if (curVertex != source_ && curVertex != sink_ && excess_[curVertex] > static_cast<TFlow>(0) && height_[curVertex] < vertexNumber_) {
+                    active_.push(curVertex);
+                }
+            }
+
+            // Exact distances to the sink in the residual network, the source is never passed through.
+            void globalRelabel () {
+                height_.assign(vertexNumber_, vertexNumber_);
+                height_[sink_] = 0;
+                heightQueue_.assign(1, sink_);
+                for (size_t head = 0; head < heightQueue_.size(); ++head) {
+                    TVertex curVertex = heightQueue_[head];
+                    for (int arc = arcBegin_[curVertex]; arc < arcBegin_[curVertex + 1]; ++arc) {
+                        TVertex previous = arcHead_[arc];
+                        if (previous != source_ && height_[previous] == vertexNumber_ && residual_[arcReversed_[arc]] > static_cast<TFlow>(0)) {
+                            height_[previous] = height_[curVertex] + 1;
+                            heightQueue_.push_back(previous);
+                        }
+                    }
+                }
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    current_[curVertex] = arcBegin_[curVertex];
+                }
+                workSinceRelabel_ = 0;
+            }
+
+            void relabel (TVertex curVertex) {
+                int minHeight = vertexNumber_;
+                for (int arc = arcBegin_[curVertex]; arc < arcBegin_[curVertex + 1]; ++arc) {
+                    if (residual_[arc] > static_cast<TFlow>(0) && height_[arcHead_[arc]] + 1 < minHeight) {
+                        minHeight = height_[arcHead_[arc]] + 1;
+                    }
+                }
+                height_[curVertex] = minHeight;
+                current_[curVertex] = arcBegin_[curVertex];
+                workSinceRelabel_ += arcBegin_[curVertex + 1] - arcBegin_[curVertex] + 12;
+            }
+
+            void discharge (TVertex curVertex) {
+                while (excess_[curVertex] > static_cast<TFlow>(0) && height_[curVertex] < vertexNumber_) {
+                    if (current_[curVertex] == arcBegin_[curVertex + 1]) {
+                        relabel(curVertex);
+                        continue;
+                    }
+                    int arc = current_[curVertex];
+                    TVertex next = arcHead_[arc];
+                    if (residual_[arc] > static_cast<TFlow>(0) && height_[curVertex] == height_[next] + 1) {
+                        bool wasActive = excess_[next] > static_cast<TFlow>(0);
+                        pushArc(arc, std::min(residual_[arc], excess_[curVertex]));
+                        if (!wasActive) {
+                            activate(next);
+                        }
+                    } else {
+                        ++current_[curVertex];
+                    }
+                }
+            }
+
+            void saturateSourceArcs () {
+                for (int arc = arcBegin_[source_]; arc < arcBegin_[source_ + 1]; ++arc) {
+                    if (residual_[arc] > static_cast<TFlow>(0)) {
+                        pushArc(arc, residual_[arc]);
+                    }
+                }
+            }
+
+            void setCapacities (TFlow lambda) {
+                for (size_t i = 0; i < parametricArc_.size(); ++i) {
+                    int arc = parametricArc_[i];
+                    TFlow cap = functions_[parametricFunction_[i]](lambda);
+                    if (cap < static_cast<TFlow>(0)) {
+                        throw NegativeCapacityException();
+                    }
+                    if (!started_) {
+                        residual_[arc] = cap;
+                    } else if (getArcStart(arc) == source_) {
+                        if (cap < parametricCap_[i]) {
+                            throw NonMonotoneCapacityException();
+                        }
+                        residual_[arc] += cap - parametricCap_[i];
+                    } else {
+                        if (cap > parametricCap_[i]) {
+                            throw NonMonotoneCapacityException();
+                        }
+                        TFlow decrease = parametricCap_[i] - cap;
+                        TFlow returned = std::max(static_cast<TFlow>(0), decrease - residual_[arc]);
+                        residual_[arc] -= decrease - returned;
+                        if (returned > static_cast<TFlow>(0)) {
+                            pushArc(arcReversed_[arc], returned);
+                            residual_[arc] -= returned;
+                        }
+                    }
+                    parametricCap_[i] = cap;
+                }
+            }
+
+        public:
+            ParametricPushRelabel (const ParametricProblem& problem, const std::vector<TCapacityFunction>& functions):
+                    functions_(functions), vertexNumber_(problem.vertexNumber), source_(problem.source), sink_(problem.sink),
+                    arcBegin_(vertexNumber_ + 1, 0), arcHead_(2 * problem.arcs.size()), arcReversed_(2 * problem.arcs.size()),
+                    residual_(2 * problem.arcs.size(), static_cast<TFlow>(0)), excess_(vertexNumber_, static_cast<TFlow>(0)),
+                    height_(vertexNumber_, 0), current_(vertexNumber_, 0), started_(false), lambda_(0), workSinceRelabel_(0) {
+                for (size_t i = 0; i < problem.arcs.size(); ++i) {
+                    ++arcBegin_[problem.arcs[i].start + 1];
+                    ++arcBegin_[problem.arcs[i].finish + 1];
+                }
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    arcBegin_[curVertex + 1] += arcBegin_[curVertex];
+                }
+                std::vector<int> position(arcBegin_.begin(), arcBegin_.end() - 1);
+                for (size_t i = 0; i < problem.arcs.size(); ++i) {
+                    const ParametricArc& arc = problem.arcs[i];
+                    int forward = position[arc.start]++;
+                    int backward = position[arc.finish]++;
+                    arcHead_[forward] = arc.finish;
+                    arcHead_[backward] = arc.start;
+                    arcReversed_[forward] = backward;
+                    arcReversed_[backward] = forward;
+                    residual_[forward] = arc.cap;
+                    if (arc.function != -1) {
+                        parametricArc_.push_back(forward);
+                        parametricFunction_.push_back(arc.function);
+                        parametricCap_.push_back(static_cast<TFlow>(0));
+                    }
+                }
+            }
+
+            // lambda must not be smaller than at the previous call.
+            void solve (TFlow lambda) {
+                if (started_ && lambda < lambda_) {
+                    throw NonMonotoneCapacityException();
+                }
+                setCapacities(lambda);
+                started_ = true;
+                lambda_ = lambda;
+                saturateSourceArcs();
+                globalRelabel();
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    activate(curVertex);
+                }
+                long long relabelThreshold = 6 * static_cast<long long>(vertexNumber_) + static_cast<long long>(arcHead_.size()) / 2;
+                while (!active_.empty()) {
+                    TVertex curVertex = active_.front();
+                    active_.pop();
+                    discharge(curVertex);
+                    if (workSinceRelabel_ > relabelThreshold) {
+                        globalRelabel();
+                        std::queue<TVertex>().swap(active_);
+                        for (TVertex vertex = static_cast<TVertex>(0); vertex < vertexNumber_; ++vertex) {
+                            activate(vertex);
+                        }
+                    }
+                }
+                globalRelabel();
+            }
+
+            TFlow getValue () const {
+                return excess_[sink_];
+            }
+
+            bool isSourceSide (TVertex curVertex) const {
+                return height_[curVertex] >= vertexNumber_;
+            }
+        };
+
+        // Max flow for a family of networks where the capacities of some source arcs grow and those of some sink arcs
+        // shrink with an integer parameter lambda. The other edges keep their capacities, the network must carry no flow.
+        // solve for a non-decreasing sequence of lambdas reuses one preflow; getBreakpoints finds every lambda where the
+        // (largest) minimum cut changes by bisection, contracting the known source and sink sides in every subproblem,
+        // so the subproblems of one recursion level together are no larger than the network.
+        class ParametricMaxFlow {
+        private:
+            Network& network_;
+            std::vector<TCapacityFunction> functions_;
+            std::vector<int> edgeFunction_;
+            std::unique_ptr<ParametricPushRelabel> warm_;
+            TFlow warmLambda_;
+            std::vector<TFlow> joinLambda_;
+
+            // Edges added to the network after the constructor get a fixed capacity, the warm preflow does not know them.
+            void updateEdgeNumber () {
+                if (edgeFunction_.size() != static_cast<size_t>(network_.getEdgeNumber())) {
+                    edgeFunction_.resize(network_.getEdgeNumber(), -1);
+                    warm_.reset();
+                }
+            }
+
+            ParametricProblem getProblem () const {
+                ParametricProblem problem;
+                problem.vertexNumber = network_.getVertexNumber();
+                problem.source = network_.getSource();
+                problem.sink = network_.getSink();
+                for (int edgeIndex = 0; edgeIndex < network_.getEdgeNumber(); ++edgeIndex) {
+                    Network::EdgeIterator edge = network_.getEdge(edgeIndex);
+                    if (edge.getCapacity() > static_cast<TFlow>(0) || edgeFunction_[edgeIndex] != -1) {
+                        ParametricArc arc = {edge.getStart(), edge.getFinish(), edge.getCapacity(), edgeFunction_[edgeIndex]};
+                        problem.arcs.push_back(arc);
+                    }
+                }
+                return problem;
+            }
+
+            TFlow getCutValue (const std::vector<bool>& sourceSide, TFlow lambda) const {
+                TFlow value = static_cast<TFlow>(0);
+                for (int edgeIndex = 0; edgeIndex < network_.getEdgeNumber(); ++edgeIndex) {
+                    Network::EdgeIterator edge = network_.getEdge(edgeIndex);
+                    if (sourceSide[edge.getStart()] && !sourceSide[edge.getFinish()]) {
+                        value += edgeFunction_[edgeIndex] == -1 ? edge.getCapacity() : functions_[edgeFunction_[edgeIndex]](lambda);
+                    }
+                }
+                return value;
+            }
+
+            // Keeps the vertices with inSide set, the others go to the source (toSource set) or to the sink.
+            // original maps the kept vertices of the result to the vertices of the network.
+            static ParametricProblem contract (const ParametricProblem& problem, const std::vector<TVertex>& original,
+                                               const std::vector<bool>& inSide, const std::vector<bool>& toSource,
+                                               std::vector<TVertex>& contractedOriginal) {
+                std::vector<TVertex> index(problem.vertexNumber);
+                contractedOriginal.clear();
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < problem.vertexNumber; ++curVertex) {
+                    if (inSide[curVertex]) {
+                        index[curVertex] = contractedOriginal.size();
+                        contractedOriginal.push_back(original[curVertex]);
+                    }
+                }
+                ParametricProblem result;
+                result.vertexNumber = contractedOriginal.size() + 2;
+                result.source = result.vertexNumber - 2;
+                result.sink = result.vertexNumber - 1;
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < problem.vertexNumber; ++curVertex) {
+                    if (!inSide[curVertex]) {
+                        index[curVertex] = toSource[curVertex] ? result.source : result.sink;
+                    }
+                }
+                for (size_t i = 0; i < problem.arcs.size(); ++i) {
+                    ParametricArc arc = problem.arcs[i];
+                    arc.start = index[arc.start];
+                    arc.finish = index[arc.finish];
+                    if (arc.start == arc.finish || arc.start == result.sink || arc.finish == result.source
+                        || (arc.start == result.source && arc.finish == result.sink)) {
+                        continue;
+                    }
+                    result.arcs.push_back(arc);
+                }
+                return result;
+            }
+
+            // In problem the source side is just the source at low and everything but the sink at high.
+            void bisect (const ParametricProblem& problem, const std::vector<TVertex>& original, TFlow low, TFlow high) {
+                if (problem.vertexNumber == 2) {
+                    return;
+                }
+                if (high - low == 1) {
+                    for (size_t i = 0; i < original.size(); ++i) {
+                        joinLambda_[original[i]] = high;
+                    }
+                    return;
+                }
+                TFlow middle = low + (high - low) / 2;
+                ParametricPushRelabel solver(problem, functions_);
+                solver.solve(middle);
+                std::vector<bool> side(problem.vertexNumber), sourceSide(problem.vertexNumber), sinkSide(problem.vertexNumber);
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < problem.vertexNumber; ++curVertex) {
+                    side[curVertex] = solver.isSourceSide(curVertex);
+                    sourceSide[curVertex] = side[curVertex] && curVertex != problem.source;
+                    sinkSide[curVertex] = !side[curVertex] && curVertex != problem.sink;
+                }
+                std::vector<TVertex> contractedOriginal;
+                ParametricProblem left = contract(problem, original, sourceSide, side, contractedOriginal);
+                bisect(left, contractedOriginal, low, middle);
+                ParametricProblem right = contract(problem, original, sinkSide, side, contractedOriginal);
+                bisect(right, contractedOriginal, middle, high);
+            }
+
+            ParametricCut makeCut (TFlow lambda, std::vector<bool>&& sourceSide) const {
+                ParametricCut cut;
+                cut.lambda = lambda;
+                cut.value = getCutValue(sourceSide, lambda);
+                cut.sourceSide = std::move(sourceSide);
+                return cut;
+            }
+
+        public:
+            ParametricMaxFlow (Network& network): network_(network), edgeFunction_(network.getEdgeNumber(), -1), warmLambda_(0) {}
+
+            // The edge must leave the source (capacity non-decreasing in lambda) or enter the sink (non-increasing).
+            void setCapacityFunction (int edgeIndex, TCapacityFunction capacity) {
+                Network::EdgeIterator edge = network_.getEdge(edgeIndex);
+                updateEdgeNumber();
+                if (edge.getStart() != network_.getSource() && edge.getFinish() != network_.getSink()) {
+                    throw InvalidEdge();
+                }
+                edgeFunction_[edgeIndex] = functions_.size();
+                functions_.push_back(capacity);
+                warm_.reset();
+            }
+
+            // Continues from the previous preflow when lambda does not decrease, otherwise starts over.
+            ParametricCut solve (TFlow lambda) {
+                updateEdgeNumber();
+                if (!warm_ || lambda < warmLambda_) {
+                    warm_.reset(new ParametricPushRelabel(getProblem(), functions_));
+                }
+                warm_->solve(lambda);
+                warmLambda_ = lambda;
+                std::vector<bool> sourceSide(network_.getVertexNumber());
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < network_.getVertexNumber(); ++curVertex) {
+                    sourceSide[curVertex] = warm_->isSourceSide(curVertex);
+                }
+                ParametricCut cut;
+                cut.lambda = lambda;
+                cut.value = warm_->getValue();
+                cut.sourceSide = std::move(sourceSide);
+                return cut;
+            }
+
+            // The cut at lambdaMin followed by the cut at every breakpoint in (lambdaMin, lambdaMax],
+            // the source sides are nested.
+            std::vector<ParametricCut> getBreakpoints (TFlow lambdaMin, TFlow lambdaMax) {
+                if (lambdaMin > lambdaMax) {
+                    throw NonMonotoneCapacityException();
+                }
+                updateEdgeNumber();
+                TVertex vertexNumber = network_.getVertexNumber();
+                ParametricProblem problem = getProblem();
+                std::vector<bool> lowSide(vertexNumber), highSide(vertexNumber);
+                ParametricPushRelabel low(problem, functions_);
+                low.solve(lambdaMin);
+                ParametricPushRelabel high(problem, functions_);
+                high.solve(lambdaMax);
+                std::vector<TVertex> original(vertexNumber);
+                std::vector<bool> between(vertexNumber);
+                joinLambda_.assign(vertexNumber, lambdaMax + 1);
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber; ++curVertex) {
+                    original[curVertex] = curVertex;
+                    lowSide[curVertex] = low.isSourceSide(curVertex);
+                    highSide[curVertex] = high.isSourceSide(curVertex);
+                    between[curVertex] = highSide[curVertex] && !lowSide[curVertex];
+                    if (lowSide[curVertex]) {
+                        joinLambda_[curVertex] = lambdaMin;
+                    }
+                }
+                std::vector<TVertex> contractedOriginal;
+                ParametricProblem inner = contract(problem, original, between, lowSide, contractedOriginal);
+                bisect(inner, contractedOriginal, lambdaMin, lambdaMax);
+
+                std::vector<TFlow> lambdas(1, lambdaMin);
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber; ++curVertex) {
+                    if (joinLambda_[curVertex] != lambdaMin && joinLambda_[curVertex] <= lambdaMax) {
+                        lambdas.push_back(joinLambda_[curVertex]);
+                    }
+                }
+                std::sort(lambdas.begin(), lambdas.end());
+                lambdas.erase(std::unique(lambdas.begin(), lambdas.end()), lambdas.end());
+                std::vector<ParametricCut> cuts;
+                for (size_t i = 0; i < lambdas.size(); ++i) {
+                    std::vector<bool> sourceSide(vertexNumber);
+                    for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber; ++curVertex) {
+                        sourceSide[curVertex] = joinLambda_[curVertex] <= lambdas[i];
+                    }
+                    cuts.push_back(makeCut(lambdas[i], std::move(sourceSide)));
+                }
+                return cuts;
+            }
+        };
+    }
+}
+#endif
@@ -0,0 +1,595 @@
+#include <chrono>
+#include <random>
+#include <string>
+#include <functional>
+#include <cstdlib>
+#include "MinCostFlow.cpp"
+#include "HopcroftKarp.cpp"
+#include "BoykovKolmogorov.cpp"
+#include "GlobalMinCut.cpp"
+#include "ParametricMaxFlow.cpp"
+
+namespace NFlow {
+    namespace NBenchmark {
+        using namespace NInner;
+
+        struct Arc {
+            TVertex start, finish;
+            TFlow cap;
+            TCost cost;
+        };
+
+        struct Instance {
+            std::string family;
+            TVertex vertexNumber, source, sink;
+            std::vector<Arc> arcs;
+
+            void addArc (TVertex start, TVertex finish, TFlow cap, TCost cost = static_cast<TCost>(0)) {
+                Arc arc = {start, finish, cap, cost};
+                arcs.push_back(arc);
+            }
+
+            void buildNetwork (Network& network) const {
+                network.reserveEdges(2 * arcs.size());
+                for (size_t i = 0; i < arcs.size(); ++i) {
+                    network.addOrEdge(arcs[i].start, arcs[i].finish, arcs[i].cap);
+                }
+            }
+
+            // MinCostFlow costs by edge index for a network built by buildNetwork, arc i is the edge 2 * i.
+            std::vector<TCost> getCosts () const {
+                std::vector<TCost> costs(2 * arcs.size(), static_cast<TCost>(0));
+                for (size_t i = 0; i < arcs.size(); ++i) {
+                    costs[2 * i] = arcs[i].cost;
+                }
+                return costs;
+            }
+
+            // Cost of the flow in a network built by buildNetwork, arc i is the edge 2 * i.
+            TCost getCost (Network& network) const {
+                TCost cost = static_cast<TCost>(0);
+                for (size_t i = 0; i < arcs.size(); ++i) {
+                    cost += network.getEdge(2 * i).getFlow() * arcs[i].cost;
+                }
+                return cost;
+            }
+        };
+
+        // Goldfarb-Grigoriadis RMF: b frames of a x a grids, in-frame arcs have capacity c2 * a * a,
+        // arcs between consecutive frames follow a random permutation with capacities in [c1, c2].
+        Instance genrmf (int a, int b, int c1, int c2, unsigned seed) {
+            std::mt19937 generator(seed);
+            Instance instance;
+            instance.family = "genrmf";
+            instance.vertexNumber = static_cast<TVertex>(a) * a * b;
+            instance.source = 0;
+            instance.sink = instance.vertexNumber - 1;
+            TFlow frameCap = static_cast<TFlow>(c2) * a * a;
+            std::vector<TVertex> permutation(a * a);
+            for (int frame = 0; frame < b; ++frame) {
+                TVertex base = static_cast<TVertex>(frame) * a * a;
+                for (int x = 0; x < a; ++x) {
+                    for (int y = 0; y < a; ++y) {
+                        TVertex curVertex = base + x * a + y;
+                        if (x + 1 < a) {
+                            instance.addArc(curVertex, curVertex + a, frameCap);
+                            instance.addArc(curVertex + a, curVertex, frameCap);
+                        }
+                        if (y + 1 < a) {
+                            instance.addArc(curVertex, curVertex + 1, frameCap);
+                            instance.addArc(curVertex + 1, curVertex, frameCap);
+                        }
+                    }
+                }
+                if (frame + 1 == b) {
+                    continue;
+                }
+                for (int i = 0; i < a * a; ++i) {
+                    permutation[i] = i;
+                }
+                std::shuffle(permutation.begin(), permutation.end(), generator);
+                for (int i = 0; i < a * a; ++i) {
+                    instance.addArc(base + i, base + a * a + permutation[i], c1 + generator() % (c2 - c1 + 1));
+                }
+            }
+            return instance;
+        }
+
+        // Washington random level graph: rows x columns, every vertex sends three arcs to random vertices of the next column.
+        Instance randomLevel (int rows, int columns, int maxCap, unsigned seed) {
+            std::mt19937 generator(seed);
+            Instance instance;
+            instance.family = "washington-rlg";
+            instance.vertexNumber = static_cast<TVertex>(rows) * columns + 2;
+            instance.source = instance.vertexNumber - 2;
+            instance.sink = instance.vertexNumber - 1;
+            for (int row = 0; row < rows; ++row) {
+                instance.addArc(instance.source, row, static_cast<TFlow>(maxCap) * rows);
+                instance.addArc(static_cast<TVertex>(columns - 1) * rows + row, instance.sink, static_cast<TFlow>(maxCap) * rows);
+            }
+            for (int column = 0; column + 1 < columns; ++column) {
+                for (int row = 0; row < rows; ++row) {
+                    for (int k = 0; k < 3; ++k) {
+                        instance.addArc(static_cast<TVertex>(column) * rows + row, static_cast<TVertex>(column + 1) * rows + generator() % rows,
+                                        1 + generator() % maxCap);
+                    }
+                }
+            }
+            return instance;
+        }
+
+        // Washington square mesh: every vertex is joined to its right neighbour and to the vertices above and below in the next column.
+        Instance washingtonGrid (int rows, int columns, int maxCap, unsigned seed) {
+            std::mt19937 generator(seed);
+            Instance instance;
+            instance.family = "washington-grid";
+            instance.vertexNumber = static_cast<TVertex>(rows) * columns + 2;
+            instance.source = instance.vertexNumber - 2;
+            instance.sink = instance.vertexNumber - 1;
+            for (int row = 0; row < rows; ++row) {
+                instance.addArc(instance.source, row, static_cast<TFlow>(maxCap) * 3);
+                instance.addArc(static_cast<TVertex>(columns - 1) * rows + row, instance.sink, static_cast<TFlow>(maxCap) * 3);
+            }
+            for (int column = 0; column + 1 < columns; ++column) {
+                for (int row = 0; row < rows; ++row) {
+                    TVertex curVertex = static_cast<TVertex>(column) * rows + row;
+                    TVertex nextColumn = curVertex + rows;
+                    instance.addArc(curVertex, nextColumn, 1 + generator() % maxCap);
+                    if (row > 0) {
+                        instance.addArc(curVertex, nextColumn - 1, 1 + generator() % maxCap);
+                    }
+                    if (row + 1 < rows) {
+                        instance.addArc(curVertex, nextColumn + 1, 1 + generator() % maxCap);
+                    }
+                }
+            }
+            return instance;
+        }
+
+        // AK-style hard family after Cherkassky-Goldberg: a chain with decreasing capacities leaking one unit
+        // to the sink from every vertex (quadratic relabeling for push-relabel) next to a long unit chain
+        // (long augmenting paths for the layered algorithms).
+        Instance akHard (int k) {
+            Instance instance;
+            instance.family = "ak";
+            instance.vertexNumber = 2 * static_cast<TVertex>(k) + 2;
+            instance.source = 0;
+            instance.sink = 1;
+            instance.addArc(instance.source, 2, k);
+            for (int i = 0; i < k; ++i) {
+                TVertex curVertex = 2 + i;
+                if (i + 1 < k) {
+                    instance.addArc(curVertex, curVertex + 1, k - i - 1);
+                }
+                instance.addArc(curVertex, instance.sink, 1);
+            }
+            instance.addArc(instance.source, 2 + k, 1);
+            for (int i = 0; i + 1 < k; ++i) {
+                instance.addArc(2 + k + i, 2 + k + i + 1, 1);
+            }
+            instance.addArc(2 + 2 * static_cast<TVertex>(k) - 1, instance.sink, 1);
+            return instance;
+        }
+
+        Instance bipartite (int leftNumber, int rightNumber, int degree, unsigned seed) {
+            std::mt19937 generator(seed);
+            Instance instance;
+            instance.family = "bipartite";
+            instance.vertexNumber = static_cast<TVertex>(leftNumber) + rightNumber + 2;
+            instance.source = instance.vertexNumber - 2;
+            instance.sink = instance.vertexNumber - 1;
+            for (int left = 0; left < leftNumber; ++left) {
+                instance.addArc(instance.source, left, 1);
+                for (int k = 0; k < degree; ++k) {
+                    instance.addArc(left, leftNumber + generator() % rightNumber, 1);
+                }
+            }
+            for (int right = 0; right < rightNumber; ++right) {
+                instance.addArc(leftNumber + right, instance.sink, 1);
+            }
+            return instance;
+        }
+
+        // Complete suppliers x consumers transportation problem with random unit costs.
+        Instance transportation (int suppliers, int consumers, int maxCost, unsigned seed) {
+            std::mt19937 generator(seed);
+            Instance instance;
+            instance.family = "transportation";
+            instance.vertexNumber = static_cast<TVertex>(suppliers) + consumers + 2;
+            instance.source = instance.vertexNumber - 2;
+            instance.sink = instance.vertexNumber - 1;
+            for (int supplier = 0; supplier < suppliers; ++supplier) {
+                instance.addArc(instance.source, supplier, 1 + generator() % 1000);
+                for (int consumer = 0; consumer < consumers; ++consumer) {
+                    instance.addArc(supplier, suppliers + consumer, 1000, generator() % maxCost);
+                }
+            }
+            for (int consumer = 0; consumer < consumers; ++consumer) {
+                instance.addArc(suppliers + consumer, instance.sink, 1 + generator() % 1000);
+            }
+            return instance;
+        }
+
+        // Image segmentation style grid: a few bright balls on a dark noisy background, terminal links pull
+        // bright voxels to the source and dark ones to the sink, neighbour capacities fall with the contrast.
+        template <class TCapacity>
+        long long fillSegmentationGrid (BasicGridNetwork<TCapacity>& grid, unsigned seed) {
+            std::mt19937 generator(seed);
+            const int BALLS = 8;
+            int centre[BALLS][3], radius[BALLS];
+            for (int ball = 0; ball < BALLS; ++ball) {
+                centre[ball][0] = generator() % grid.getWidth();
+                centre[ball][1] = generator() % grid.getHeight();
+                centre[ball][2] = generator() % grid.getDepth();
+                radius[ball] = 1 + generator() % (1 + std::max(grid.getWidth(), grid.getHeight()) / 6);
+            }
+            std::vector<int> intensity(grid.getVertexNumber());
+            for (int z = 0; z < grid.getDepth(); ++z) {
+                for (int y = 0; y < grid.getHeight(); ++y) {
+                    for (int x = 0; x < grid.getWidth(); ++x) {
+                        int value = 60;
+                        for (int ball = 0; ball < BALLS; ++ball) {
+                            long long dx = x - centre[ball][0], dy = y - centre[ball][1], dz = z - centre[ball][2];
+                            if (dx * dx + dy * dy + dz * dz <= static_cast<long long>(radius[ball]) * radius[ball]) {
+                                value = 200;
+                            }
+                        }
+                        intensity[grid.getVertex(x, y, z)] = value + static_cast<int>(generator() % 81) - 40;
+                    }
+                }
+            }
+            long long arcs = 0;
+            for (TVertex curVertex = static_cast<TVertex>(0); curVertex < grid.getVertexNumber(); ++curVertex) {
+                int data = intensity[curVertex] - 130;
+                if (data != 0) {
+                    grid.addTerminalCapacity(curVertex, std::max(data, 0), std::max(-data, 0));
+                    ++arcs;
+                }
+                for (int direction = 0; direction < grid.getDirectionNumber(); ++direction) {
+                    if (grid.hasNeighbour(curVertex, direction)) {
+                        int contrast = std::abs(intensity[curVertex] - intensity[grid.getNeighbour(curVertex, direction)]);
+                        grid.addEdge(curVertex, direction, std::max(1, 60 - contrast / 2));
+                        ++arcs;
+                    }
+                }
+            }
+            return arcs;
+        }
+
+        // The same grid as an explicit network, the source and the sink are the two last vertices.
+        template <class TCapacity>
+        Instance gridInstance (const BasicGridNetwork<TCapacity>& grid) {
+            Instance instance;
+            instance.family = grid.getDepth() > 1 ? "grid-3d" : "grid-2d";
+            instance.vertexNumber = grid.getVertexNumber() + 2;
+            instance.source = instance.vertexNumber - 2;
+            instance.sink = instance.vertexNumber - 1;
+            for (TVertex curVertex = static_cast<TVertex>(0); curVertex < grid.getVertexNumber(); ++curVertex) {
+                TFlow terminal = grid.getTerminalResidual(curVertex);
+                if (terminal > static_cast<TFlow>(0)) {
+                    instance.addArc(instance.source, curVertex, terminal);
+                } else if (terminal < static_cast<TFlow>(0)) {
+                    instance.addArc(curVertex, instance.sink, -terminal);
+                }
+                for (int direction = 0; direction < grid.getDirectionNumber(); ++direction) {
+                    if (grid.hasNeighbour(curVertex, direction) && grid.getResidualCapacity(curVertex, direction) > 0) {
+                        instance.addArc(curVertex, grid.getNeighbour(curVertex, direction), grid.getResidualCapacity(curVertex, direction));
+                    }
+                }
+            }
+            return instance;
+        }
+
+        struct Engine {
+            std::string name;
+            std::function<Algorithm* (Network&, const Instance&)> create;
+        };
+
+        struct Result {
+            TFlow flow;
+            TCost cost;
+            bool feasible;
+        };
+
+        bool firstRecord = true;
+
+        void printRecord (const std::string& family, const std::string& engine, TVertex vertices, size_t arcs, const Result& result,
+                          double seconds, const Statistics& statistics) {
+            printf("%s\n  {\"family\": \"%s\", \"engine\": \"%s\", \"vertices\": %lld, \"arcs\": %zu, \"flow\": %lld, \"cost\": %lld, "
+                   "\"seconds\": %.6f, \"phases\": %lld, \"pushes\": %lld, \"saturating_pushes\": %lld, \"relabels\": %lld, \"augmentations\": %lld",
+                   firstRecord ? "" : ",", family.c_str(), engine.c_str(), vertices, arcs,
+                   result.flow, result.cost, seconds, statistics.phases, statistics.pushes, statistics.saturatingPushes,
+                   statistics.relabels, statistics.augmentations);
+            firstRecord = false;
+        }
+
+        // The flow left in the network must respect every capacity, be antisymmetric and conserved at every vertex
+        // but the terminals and have the reported value; the minimum cut of the engine must separate the source
+        // from the sink and its edges, recounted here, must have the same capacity.
+        bool isFeasible (Network& network, TFlow flow, const MinCut& cut) {
+            TVertex vertexNumber = network.getVertexNumber();
+            std::vector<TFlow> excess(vertexNumber, static_cast<TFlow>(0));
+            for (int edgeIndex = 0; edgeIndex < network.getEdgeNumber(); ++edgeIndex) {
+                Network::EdgeIterator edge = network.getEdge(edgeIndex);
+                if (edge.getFlow() > edge.getCapacity() || edge.getFlow() != -network.getEdge(edgeIndex ^ 1).getFlow()) {
+                    return false;
+                }
+                excess[edge.getFinish()] += edge.getFlow();
+            }
+            for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber; ++curVertex) {
+                if (curVertex != network.getSource() && curVertex != network.getSink() && excess[curVertex] != static_cast<TFlow>(0)) {
+                    return false;
+                }
+            }
+            if (excess[network.getSink()] != flow || network.getFlow() != flow) {
+                return false;
+            }
+            if (static_cast<TVertex>(cut.sourceSide.size()) != vertexNumber || !cut.sourceSide[network.getSource()]
+                || cut.sourceSide[network.getSink()]) {
+                return false;
+            }
+            TFlow cutValue = static_cast<TFlow>(0);
+            for (int edgeIndex = 0; edgeIndex < network.getEdgeNumber(); ++edgeIndex) {
+                Network::EdgeIterator edge = network.getEdge(edgeIndex);
+                if (cut.sourceSide[edge.getStart()] && !cut.sourceSide[edge.getFinish()]) {
+                    cutValue += edge.getCapacity();
+                }
+            }
+            return cutValue == flow && cut.value == flow;
+        }
+
+        Result run (const Instance& instance, const Engine& engine) {
+            Network network(instance.vertexNumber, instance.source, instance.sink);
+            instance.buildNetwork(network);
+            std::unique_ptr<Algorithm> algorithm(engine.create(network, instance));
+            auto start = std::chrono::steady_clock::now();
+            Result result;
+            result.flow = algorithm->getMaxFlow();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            result.cost = instance.getCost(network);
+            result.feasible = isFeasible(network, result.flow, algorithm->getMinCut());
+            printRecord(instance.family, engine.name, instance.vertexNumber, instance.arcs.size(), result, seconds, algorithm->getStatistics());
+            return result;
+        }
+
+        // Every engine of the list must leave a feasible flow and a matching cut, and agree with the first one
+        // on the flow (and on the cost when checkCost is set).
+        bool runAll (const Instance& instance, const std::vector<Engine>& engines, bool checkCost) {
+            bool consistent = true;
+            Result reference;
+            for (size_t i = 0; i < engines.size(); ++i) {
+                Result result = run(instance, engines[i]);
+                if (i == 0) {
+                    reference = result;
+                }
+                bool agrees = result.feasible && result.flow == reference.flow && (!checkCost || result.cost == reference.cost);
+                printf(", \"consistent\": %s}", agrees ? "true" : "false");
+                consistent = consistent && agrees;
+            }
+            return consistent;
+        }
+
+        // Boykov-Kolmogorov on the implicit grid with int capacities, then every engine of the list on the explicit copy.
+        bool runGrid (int width, int height, int depth, unsigned seed, const std::vector<Engine>& engines) {
+            BasicGridNetwork<int> grid(width, height, depth);
+            long long arcs = fillSegmentationGrid(grid, seed);
+            Instance instance;
+            if (!engines.empty()) {
+                instance = gridInstance(grid);
+            }
+            BasicBoykovKolmogorov<int> algorithm(grid);
+            auto start = std::chrono::steady_clock::now();
+            Result reference;
+            reference.flow = algorithm.getMaxFlow();
+            reference.cost = static_cast<TCost>(0);
+            reference.feasible = true;
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            printRecord(depth > 1 ? "grid-3d" : "grid-2d", "boykov-kolmogorov", grid.getVertexNumber() + 2, arcs, reference, seconds, algorithm.getStatistics());
+            printf(", \"consistent\": true}");
+            bool consistent = true;
+            for (size_t i = 0; i < engines.size(); ++i) {
+                Result result = run(instance, engines[i]);
+                bool agrees = result.feasible && result.flow == reference.flow;
+                printf(", \"consistent\": %s}", agrees ? "true" : "false");
+                consistent = consistent && agrees;
+            }
+            return consistent;
+        }
+
+        // Sparse undirected graph: a ring keeps it connected, every vertex adds degree random edges.
+        Instance sparseUndirected (int vertexNumber, int degree, int maxCap, unsigned seed) {
+            std::mt19937 generator(seed);
+            Instance instance;
+            instance.family = "global-min-cut";
+            instance.vertexNumber = vertexNumber;
+            instance.source = 0;
+            instance.sink = vertexNumber - 1;
+            for (int curVertex = 0; curVertex < vertexNumber; ++curVertex) {
+                instance.addArc(curVertex, (curVertex + 1) % vertexNumber, 1 + generator() % maxCap);
+                for (int k = 0; k < degree; ++k) {
+                    instance.addArc(curVertex, generator() % vertexNumber, 1 + generator() % maxCap);
+                }
+            }
+            return instance;
+        }
+
+        // Stoer-Wagner, Karger-Stein on 1, 2, ... maxThreads threads and the s-t approach (V - 1 MKM flows from
+        // vertex 0) on the same undirected network; the flow field holds the cut value.
+        bool runGlobalMinCut (const Instance& instance, size_t maxThreads) {
+            Network network(instance.vertexNumber, instance.source, instance.sink);
+            for (size_t i = 0; i < instance.arcs.size(); ++i) {
+                network.addEdge(instance.arcs[i].start, instance.arcs[i].finish, instance.arcs[i].cap);
+            }
+            std::vector<std::pair<std::string, std::function<TFlow ()> > > engines;
+            engines.push_back(std::make_pair(std::string("stoer-wagner"), [&network] () { return StoerWagner(network).getMinCut().value; }));
+            for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+                engines.push_back(std::make_pair("karger-stein-" + std::to_string(threads),
+                                                 [&network, threads] () { return KargerStein(network, 0, threads).getMinCut().value; }));
+            }
+            engines.push_back(std::make_pair(std::string("st-flows-mkm"), [&network] () {
+                TFlow best = std::numeric_limits<TFlow>::max();
+                for (TVertex sink = static_cast<TVertex>(1); sink < network.getVertexNumber(); ++sink) {
+                    network.resetFlow();
+                    network.setTerminals(0, sink);
+                    best = std::min(best, MalCumMah(network).getMaxFlow());
+                }
+                return best;
+            }));
+            bool consistent = true;
+            Result reference;
+            for (size_t i = 0; i < engines.size(); ++i) {
+                auto start = std::chrono::steady_clock::now();
+                Result result;
+                result.flow = engines[i].second();
+                result.cost = static_cast<TCost>(0);
+                result.feasible = true;
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                printRecord(instance.family, engines[i].first, instance.vertexNumber, instance.arcs.size(), result, seconds, Statistics());
+                if (i == 0) {
+                    reference = result;
+                }
+                bool agrees = result.flow == reference.flow;
+                printf(", \"consistent\": %s}", agrees ? "true" : "false");
+                consistent = consistent && agrees;
+            }
+            return consistent;
+        }
+
+        // Source arc i grows and sink arc i shrinks by (1 + i % 5) / 64 of its capacity per unit of lambda,
+        // the other arcs get no function and keep their capacities.
+        std::vector<TCapacityFunction> getParametricFunctions (const Instance& instance) {
+            std::vector<TCapacityFunction> functions(instance.arcs.size());
+            for (size_t i = 0; i < instance.arcs.size(); ++i) {
+                TFlow cap = instance.arcs[i].cap;
+                TFlow slope = static_cast<TFlow>(1 + i % 5);
+                if (instance.arcs[i].start == instance.source) {
+                    functions[i] = [cap, slope] (TFlow lambda) { return cap / 4 + lambda * slope * cap / 64; };
+                } else if (instance.arcs[i].finish == instance.sink) {
+                    functions[i] = [cap, slope] (TFlow lambda) { return std::max(static_cast<TFlow>(0), cap - lambda * slope * cap / 64); };
+                }
+            }
+            return functions;
+        }
+
+        TFlow getParametricCutValue (const Instance& instance, const std::vector<TCapacityFunction>& functions,
+                                     const std::vector<bool>& sourceSide, TFlow lambda) {
+            TFlow value = static_cast<TFlow>(0);
+            for (size_t i = 0; i < instance.arcs.size(); ++i) {
+                if (sourceSide[instance.arcs[i].start] && !sourceSide[instance.arcs[i].finish]) {
+                    value += functions[i] ? functions[i](lambda) : instance.arcs[i].cap;
+                }
+            }
+            return value;
+        }
+
+        // Per-lambda cross-check of ParametricMaxFlow: MKM from scratch on the network with the capacities of every
+        // lambda in [0, lambdaMax] is the reference, the warm-started solve sweep and the breakpoint cuts must give
+        // the same value at every lambda and their source sides must be cuts of that value. The flow field holds
+        // the sum of the values over the sweep.
+        bool runParametric (const Instance& instance, TFlow lambdaMax) {
+            std::vector<TCapacityFunction> functions = getParametricFunctions(instance);
+            std::vector<TFlow> reference(lambdaMax + 1);
+            Result result;
+            result.flow = static_cast<TFlow>(0);
+            result.cost = static_cast<TCost>(0);
+            result.feasible = true;
+            auto start = std::chrono::steady_clock::now();
+            for (TFlow lambda = static_cast<TFlow>(0); lambda <= lambdaMax; ++lambda) {
+                Network network(instance.vertexNumber, instance.source, instance.sink);
+                for (size_t i = 0; i < instance.arcs.size(); ++i) {
+                    network.addOrEdge(instance.arcs[i].start, instance.arcs[i].finish, functions[i] ? functions[i](lambda) : instance.arcs[i].cap);
+                }
+                reference[lambda] = MalCumMah(network).getMaxFlow();
+                result.flow += reference[lambda];
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            printRecord("parametric", "mkm-per-lambda", instance.vertexNumber, instance.arcs.size(), result, seconds, Statistics());
+            printf(", \"consistent\": true}");
+
+            Network network(instance.vertexNumber, instance.source, instance.sink);
+            instance.buildNetwork(network);
+            ParametricMaxFlow parametric(network);
+            for (size_t i = 0; i < instance.arcs.size(); ++i) {
+                if (functions[i]) {
+                    parametric.setCapacityFunction(2 * i, functions[i]);
+                }
+            }
+
+            bool agrees = true;
+            result.flow = static_cast<TFlow>(0);
+            start = std::chrono::steady_clock::now();
+            for (TFlow lambda = static_cast<TFlow>(0); lambda <= lambdaMax; ++lambda) {
+                ParametricCut cut = parametric.solve(lambda);
+                agrees = agrees && cut.value == reference[lambda]
+                         && getParametricCutValue(instance, functions, cut.sourceSide, lambda) == reference[lambda];
+                result.flow += cut.value;
+            }
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            printRecord("parametric", "warm-solve-sweep", instance.vertexNumber, instance.arcs.size(), result, seconds, Statistics());
+            printf(", \"consistent\": %s}", agrees ? "true" : "false");
+            bool consistent = agrees;
+
+            start = std::chrono::steady_clock::now();
+            std::vector<ParametricCut> cuts = parametric.getBreakpoints(0, lambdaMax);
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            agrees = !cuts.empty() && cuts[0].lambda == 0;
+            result.flow = static_cast<TFlow>(0);
+            size_t current = 0;
+            for (TFlow lambda = static_cast<TFlow>(0); agrees && lambda <= lambdaMax; ++lambda) {
+                while (current + 1 < cuts.size() && cuts[current + 1].lambda <= lambda) {
+                    ++current;
+                }
+                TFlow value = getParametricCutValue(instance, functions, cuts[current].sourceSide, lambda);
+                agrees = value == reference[lambda] && (cuts[current].lambda != lambda || cuts[current].value == value);
+                result.flow += value;
+            }
+            printRecord("parametric", "breakpoints-" + std::to_string(cuts.size()), instance.vertexNumber, instance.arcs.size(), result, seconds,
+                        Statistics());
+            printf(", \"consistent\": %s}", agrees ? "true" : "false");
+            return consistent && agrees;
+        }
+    }
+}
+
+// Usage: benchmark [scale] [max threads]; prints a JSON array with one record per (instance, engine) run.
+// The large grid is 1024 * scale squared, so scale 4 runs Boykov-Kolmogorov on 4096 x 4096.
+int main (int argc, char* argv[]) {
+    using namespace NFlow::NBenchmark;
+    int scale = argc > 1 ? std::atoi(argv[1]) : 1;
+    size_t maxThreads = argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+    if (scale < 1) {
+        scale = 1;
+    }
+    if (maxThreads < 1) {
+        maxThreads = 1;
+    }
+
+    std::vector<Engine> flowEngines;
+    flowEngines.push_back(Engine{"relabel-to-front", [] (Network& network, const Instance&) -> Algorithm* { return new BasicRelabelToFront<CollectStatistics>(network); }});
+    flowEngines.push_back(Engine{"mkm", [] (Network& network, const Instance&) -> Algorithm* { return new BasicMalCumMah<CollectStatistics>(network); }});
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        flowEngines.push_back(Engine{"parallel-push-relabel-" + std::to_string(threads),
+                                     [threads] (Network& network, const Instance&) -> Algorithm* { return new ParallelPushRelabel(network, threads); }});
+    }
+    std::vector<Engine> matchingEngines(flowEngines);
+    matchingEngines.push_back(Engine{"hopcroft-karp", [] (Network& network, const Instance&) -> Algorithm* { return new BipartiteMatchingAdapter(network); }});
+    std::vector<Engine> costEngines;
+    costEngines.push_back(Engine{"min-cost-ssp", [] (Network& network, const Instance& instance) -> Algorithm* { return new MinCostFlow(network, instance.getCosts()); }});
+    costEngines.push_back(Engine{"min-cost-scaling", [] (Network& network, const Instance& instance) -> Algorithm* { return new MinCostFlow(network, instance.getCosts(), COST_SCALING); }});
+
+    bool consistent = true;
+    printf("[");
+    consistent &= runAll(genrmf(6 * scale, 8 * scale, 1, 1000, 1), flowEngines, false);
+    consistent &= runAll(randomLevel(32 * scale, 32 * scale, 1000, 2), flowEngines, false);
+    consistent &= runAll(washingtonGrid(32 * scale, 32 * scale, 1000, 3), flowEngines, false);
+    consistent &= runAll(akHard(500 * scale), flowEngines, false);
+    consistent &= runAll(bipartite(500 * scale, 500 * scale, 4, 4), matchingEngines, false);
+    consistent &= runAll(transportation(100 * scale, 100 * scale, 1000, 5), costEngines, true);
+    consistent &= runGrid(64 * scale, 64 * scale, 1, 6, flowEngines);
+    consistent &= runGrid(16 * scale, 16 * scale, 16 * scale, 7, flowEngines);
+    consistent &= runGrid(1024 * scale, 1024 * scale, 1, 8, std::vector<Engine>());
+    consistent &= runGlobalMinCut(sparseUndirected(300 * scale, 2, 1000, 9), maxThreads);
+    consistent &= runParametric(randomLevel(16 * scale, 16 * scale, 1000, 10), 64);
+    printf("\n]\n");
+    return consistent ? 0 : 1;
+}
@@ -5,6 +5,10 @@
 #include <iostream>
 #include <queue>
 #include <cmath>
+#include <algorithm>
+#include <unordered_map>
+#include <chrono>
+#include <functional>
 
 typedef long long TFlow;
 typedef long long TVertex;
@@ -21,6 +25,8 @@ namespace NFlow {
             TVertex start, finish;
             TFlow cap, flow;
 
+            Edge () {}
+
             Edge (TVertex start, TVertex finish, TFlow cap, TFlow flow): start(start), finish(finish), cap(cap), flow(flow) {}
         };
 
@@ -36,6 +42,16 @@ namespace NFlow {
 
         struct InvalidVertex : public std::exception {};
 
+        struct InvalidEdge : public std::exception {};
+
+        struct ReleasedWorkspaceException : public std::exception {};
+
+        struct MinCut {
+            TFlow value;
+            std::vector<bool> sourceSide;
+            std::vector<int> edges;
+        };
+
         class Network {
         private:
             TVertex vertexNumber_;
@@ -45,6 +61,26 @@ namespace NFlow {
             std::vector<int> ptr_;
             std::vector<int> lasts_;
 
+            // Edges whose capacity or flow changed since the last clearTouchedEdges, one index per edge pair;
+            // nothing is recorded before the first clearTouchedEdges call.
+            std::vector<int> touched_;
+            std::vector<bool> isTouched_;
+            bool trackTouched_;
+
+            void touch (int edgeIndex) {
+                if (!trackTouched_) {
+                    return;
+                }
+                edgeIndex &= ~1;
+                if (isTouched_.size() < edges_.size() / 2) {
+                    isTouched_.resize(edges_.size() / 2, false);
+                }
+                if (!isTouched_[edgeIndex / 2]) {
+                    isTouched_[edgeIndex / 2] = true;
+                    touched_.push_back(edgeIndex);
+                }
+            }
+
             void addEdgeLocal (TVertex start, TVertex finish, TFlow cap, TFlow flow) {
                 edges_.push_back(Edge(start, finish, cap, flow));
                 if (lasts_[start] == -1) {
@@ -57,8 +93,89 @@ namespace NFlow {
                 }
             }
 
+            // Sends amount of excess (direction = -1) or deficit (direction = 1) at start back along the flow
+            // carrying arcs until it is absorbed by the source, the sink or the partner vertex, which holds
+            // the opposite imbalance, cancelling flow cycles on the way. Returns the amount absorbed by the partner.
+            // Only the visited vertices are touched, so the cost depends on the repaired region, not on the network.
+            TFlow cancelFlow (TVertex start, TFlow amount, int direction, TVertex partner) {
+                TFlow absorbedByPartner = static_cast<TFlow>(0);
+                std::vector<int> path;
+                std::vector<TVertex> pathVertices(1, start);
+                std::unordered_map<TVertex, size_t> pathPosition;
+                std::unordered_map<TVertex, int> arcPtr;
+                pathPosition[start] = 0;
+                while (amount > static_cast<TFlow>(0)) {
+                    TVertex curVertex = pathVertices.back();
+                    if (curVertex == source_ || curVertex == sink_ || (curVertex == partner && !path.empty())) {
+                        TFlow change = amount;
+                        for (size_t i = 0; i < path.size(); ++i) {
+                            change = std::min(change, direction * edges_[path[i]].flow);
+                        }
+                        for (size_t i = 0; i < path.size(); ++i) {
+                            edges_[path[i]].flow -= direction * change;
+                            edges_[path[i] ^ 1].flow += direction * change;
+                            touch(path[i]);
+                        }
+                        amount -= change;
+                        if (curVertex == partner) {
+                            absorbedByPartner += change;
+                        }
+                        for (size_t i = 1; i < pathVertices.size(); ++i) {
+                            pathPosition.erase(pathVertices[i]);
+                        }
+                        path.clear();
+                        pathVertices.resize(1);
+                        continue;
+                    }
+                    if (arcPtr.find(curVertex) == arcPtr.end()) {
+                        arcPtr[curVertex] = lasts_[curVertex];
+                    }
+                    int& edgeIndex = arcPtr[curVertex];
+                    while (edgeIndex != -1 && direction * edges_[edgeIndex].flow <= static_cast<TFlow>(0)) {
+                        edgeIndex = ptr_[edgeIndex];
+                    }
+                    if (edgeIndex == -1) {
+                        if (path.empty()) {
+                            return absorbedByPartner;
+                        }
+                        pathPosition.erase(curVertex);
+                        pathVertices.pop_back();
+                        path.pop_back();
+                        int& parentEdgeIndex = arcPtr[pathVertices.back()];
+                        parentEdgeIndex = ptr_[parentEdgeIndex];
+                        continue;
+                    }
+                    TVertex nextVertex = edges_[edgeIndex].finish;
+                    auto cycleStart = pathPosition.find(nextVertex);
+                    if (cycleStart == pathPosition.end()) {
+                        pathPosition[nextVertex] = pathVertices.size();
+                        pathVertices.push_back(nextVertex);
+                        path.push_back(edgeIndex);
+                        continue;
+                    }
+                    size_t cycleBegin = cycleStart->second;
+                    path.push_back(edgeIndex);
+                    TFlow change = direction * edges_[edgeIndex].flow;
+                    for (size_t i = cycleBegin; i < path.size(); ++i) {
+                        change = std::min(change, direction * edges_[path[i]].flow);
+                    }
+                    for (size_t i = cycleBegin; i < path.size(); ++i) {
+                        edges_[path[i]].flow -= direction * change;
+                        edges_[path[i] ^ 1].flow += direction * change;
+                        touch(path[i]);
+                    }
+                    for (size_t i = cycleBegin + 1; i < pathVertices.size(); ++i) {
+                        pathPosition.erase(pathVertices[i]);
+                    }
+                    path.resize(cycleBegin);
+                    pathVertices.resize(cycleBegin + 1);
+                }
+                return absorbedByPartner;
+            }
+
         public:
-            Network (TVertex vertexNumber, TVertex source, TVertex sink): vertexNumber_(vertexNumber), source_(source), sink_(sink), lasts_(vertexNumber, -1) {
+            Network (TVertex vertexNumber, TVertex source, TVertex sink): vertexNumber_(vertexNumber), source_(source), sink_(sink), lasts_(vertexNumber, -1),
+                    trackTouched_(false) {
                 if (source == sink) {
                     throw SourceIsEqualToSinkException();
                 }
@@ -70,20 +187,94 @@ namespace NFlow {
                 }
             }
 
-            void addOrEdge (TVertex start, TVertex finish, TFlow cap) {
+            // Every addOrEdge or addEdge call adds two edges.
+            void reserveEdges (int edgeNumber) {
+                edges_.reserve(edgeNumber);
+                ptr_.reserve(edgeNumber);
+            }
+
+            // Returns the index of the added edge, its reversed edge has index ^ 1.
+            int addOrEdge (TVertex start, TVertex finish, TFlow cap) {
                 if (cap < static_cast<TFlow>(0)) {
                     throw NegativeCapacityException();
                 }
                 addEdgeLocal (start, finish, cap, static_cast<TFlow>(0));
                 addEdgeLocal (finish, start, static_cast<TFlow>(0), static_cast<TFlow>(0));
+                touch(edges_.size() - 2);
+                return edges_.size() - 2;
             }
 
-            void addEdge(TVertex start, TVertex finish, TVertex cap) {
+            int addEdge(TVertex start, TVertex finish, TVertex cap) {
                 if (cap < static_cast<TFlow>(0)) {
                     throw NegativeCapacityException();
                 }
                 addEdgeLocal(start, finish, cap, static_cast<TFlow>(0));
                 addEdgeLocal(finish, start, cap, static_cast<TFlow>(0));
+                touch(edges_.size() - 2);
+                return edges_.size() - 2;
+            }
+
+            // Keeps the current flow; if it exceeds the new capacity the surplus is cancelled
+            // back towards the source and the sink so the flow stays feasible and solvers can resume from it.
+            void changeCapacity (int edgeIndex, TFlow cap) {
+                if (edgeIndex < 0 || edgeIndex >= static_cast<int>(edges_.size())) {
+                    throw InvalidEdge();
+                }
+                if (cap < static_cast<TFlow>(0)) {
+                    throw NegativeCapacityException();
+                }
+                edges_[edgeIndex].cap = cap;
+                touch(edgeIndex);
+                TFlow surplus = edges_[edgeIndex].flow - cap;
+                if (surplus <= static_cast<TFlow>(0)) {
+                    return;
+                }
+                edges_[edgeIndex].flow -= surplus;
+                edges_[edgeIndex ^ 1].flow += surplus;
+                TVertex start = edges_[edgeIndex].start;
+                TVertex finish = edges_[edgeIndex].finish;
+                TFlow deficit = surplus;
+                if (start != source_ && start != sink_) {
+                    deficit -= cancelFlow(start, surplus, -1, finish);
+                }
+                if (finish != source_ && finish != sink_ && deficit > static_cast<TFlow>(0)) {
+                    cancelFlow(finish, deficit, 1, -1);
+                }
+            }
+
+            // Solvers can then be run again on the same edges, e.g. after setTerminals.
+            void resetFlow () {
+                for (size_t edgeIndex = 0; edgeIndex < edges_.size(); ++edgeIndex) {
+                    edges_[edgeIndex].flow = static_cast<TFlow>(0);
+                }
+            }
+
+            // Only meant for a network without flow, the flow value is read at the current source.
+            void setTerminals (TVertex source, TVertex sink) {
+                if (source == sink) {
+                    throw SourceIsEqualToSinkException();
+                }
+                if (source >= vertexNumber_ || sink >= vertexNumber_) {
+                    throw TooBigSourceOrSinkException();
+                }
+                if (source < static_cast<TVertex>(0) || sink < 0) {
+                    throw NegativeSourceOrSinkException();
+                }
+                source_ = source;
+                sink_ = sink;
+            }
+
+            // A solver that keeps its labels between solves looks only at these edges when it is run again.
+            const std::vector<int>& getTouchedEdges () const {
+                return touched_;
+            }
+
+            void clearTouchedEdges () {
+                for (size_t i = 0; i < touched_.size(); ++i) {
+                    isTouched_[touched_[i] / 2] = false;
+                }
+                touched_.clear();
+                trackTouched_ = true;
             }
 
             TVertex getVertexNumber () const {
@@ -98,8 +289,14 @@ namespace NFlow {
                 return sink_;
             }
 
+            int getEdgeNumber () const {
+                return edges_.size();
+            }
+
             friend class EdgeIterator;
 
+            friend class NetworkIO;
+
             class EdgeIterator {
             private:
                 Network& network_;
@@ -119,6 +316,10 @@ namespace NFlow {
                     return edgeIndex_ != -1;
                 }
 
+                int getIndex () const {
+                    return edgeIndex_;
+                }
+
                 EdgeIterator next () {
                     if (!isValid()) {
                         throw InvalidIteratorAction();
@@ -167,6 +368,13 @@ namespace NFlow {
                 return EdgeIterator(lasts_[vertexIdx], *this);
             }
 
+            EdgeIterator getEdge (int edgeIndex) {
+                if (edgeIndex < 0 || edgeIndex >= static_cast<int>(edges_.size())) {
+                    throw InvalidEdge();
+                }
+                return EdgeIterator(edgeIndex, *this);
+            }
+
             TFlow getFlow () {
                 TFlow curFlow = static_cast<TFlow>(0);
                 for (Network::EdgeIterator it = getEdgeListBegin(source_); it.isValid(); it.next()) {
@@ -174,31 +382,339 @@ namespace NFlow {
                 }
                 return curFlow;
             }
+
+            // Collects the edges leaving the given source side, their capacities sum up to the cut value.
+            MinCut getCut (std::vector<bool>&& sourceSide) const {
+                MinCut cut;
+                cut.value = static_cast<TFlow>(0);
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    if (!sourceSide[curVertex]) {
+                        continue;
+                    }
+                    for (int edgeIndex = lasts_[curVertex]; edgeIndex != -1; edgeIndex = ptr_[edgeIndex]) {
+                        if (!sourceSide[edges_[edgeIndex].finish] && edges_[edgeIndex].cap > static_cast<TFlow>(0)) {
+                            cut.value += edges_[edgeIndex].cap;
+                            cut.edges.push_back(edgeIndex);
+                        }
+                    }
+                }
+                cut.sourceSide = std::move(sourceSide);
+                return cut;
+            }
+        };
+
+        // Addressable 4-ary min-heap over items 0..size - 1, setKey inserts an item or moves it to its new key.
+        template <class TKey>
+        class IndexedHeap {
+        private:
+            static const int ARITY = 4;
+
+            std::vector<TKey> keys_;
+            std::vector<int> heap_;
+            std::vector<int> position_;
+
+            void place (int pos, int item) {
+                heap_[pos] = item;
+                position_[item] = pos;
+            }
+
+            void siftUp (int pos) {
+                int item = heap_[pos];
+                while (pos > 0) {
+                    int parent = (pos - 1) / ARITY;
+                    if (!(keys_[item] < keys_[heap_[parent]])) {
+                        break;
+                    }
+                    place(pos, heap_[parent]);
+                    pos = parent;
+                }
+                place(pos, item);
+            }
+
+            void siftDown (int pos) {
+                int item = heap_[pos];
+                int size = heap_.size();
+                while (true) {
+                    int best = -1;
+                    for (int child = pos * ARITY + 1; child <= pos * ARITY + ARITY && child < size; ++child) {
+                        if (best == -1 || keys_[heap_[child]] < keys_[heap_[best]]) {
+                            best = child;
+                        }
+                    }
+                    if (best == -1 || !(keys_[heap_[best]] < keys_[item])) {
+                        break;
+                    }
+                    place(pos, heap_[best]);
+                    pos = best;
+                }
+                place(pos, item);
+            }
+
+        public:
+            IndexedHeap (size_t size): keys_(size), position_(size, -1) {}
+
+            bool empty () const {
+                return heap_.empty();
+            }
+
+            bool contains (int item) const {
+                return position_[item] != -1;
+            }
+
+            TKey getKey (int item) const {
+                return keys_[item];
+            }
+
+            int top () const {
+                return heap_[0];
+            }
+
+            void setKey (int item, TKey key) {
+                if (!contains(item)) {
+                    keys_[item] = key;
+                    heap_.push_back(item);
+                    siftUp(heap_.size() - 1);
+                    return;
+                }
+                bool decrease = key < keys_[item];
+                keys_[item] = key;
+                if (decrease) {
+                    siftUp(position_[item]);
+                } else {
+                    siftDown(position_[item]);
+                }
+            }
+
+            void erase (int item) {
+                int pos = position_[item];
+                position_[item] = -1;
+                int last = heap_.back();
+                heap_.pop_back();
+                if (last == item) {
+                    return;
+                }
+                place(pos, last);
+                siftUp(pos);
+                siftDown(position_[last]);
+            }
+
+            int pop () {
+                int item = heap_[0];
+                erase(item);
+                return item;
+            }
+
+            void clear () {
+                for (size_t i = 0; i < heap_.size(); ++i) {
+                    position_[heap_[i]] = -1;
+                }
+                heap_.clear();
+            }
+
+            // Empties the heap and makes it hold items 0..size - 1, the allocated memory is kept.
+            void resize (size_t size) {
+                clear();
+                keys_.resize(size);
+                position_.resize(size, -1);
+            }
+        };
+
+        struct Statistics {
+            long long phases, pushes, saturatingPushes, relabels, augmentations;
+            std::vector<double> phaseSeconds;
+
+            Statistics (): phases(0), pushes(0), saturatingPushes(0), relabels(0), augmentations(0) {}
+
+            long long getNonSaturatingPushes () const {
+                return pushes - saturatingPushes;
+            }
+        };
+
+        // Statistics policies for the algorithm templates. The hooks are non-virtual and inline,
+        // so with NoStatistics every call compiles away.
+        class NoStatistics {
+        public:
+            void beginPhase () {}
+
+            void endPhase () {}
+
+            void onPush (bool) {}
+
+            void onRelabel () {}
+
+            void onAugmentation () {}
+
+            Statistics get () const {
+                return Statistics();
+            }
+        };
+
+        class CollectStatistics {
+        protected:
+            Statistics statistics_;
+            std::chrono::steady_clock::time_point phaseStart_;
+
+        public:
+            void beginPhase () {
+                phaseStart_ = std::chrono::steady_clock::now();
+            }
+
+            // A phase is counted only when it ends, so a phase that was begun and abandoned is not reported.
+            void endPhase () {
+                ++statistics_.phases;
+                statistics_.phaseSeconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - phaseStart_).count());
+            }
+
+            void onPush (bool saturating) {
+                ++statistics_.pushes;
+                if (saturating) {
+                    ++statistics_.saturatingPushes;
+                }
+            }
+
+            void onRelabel () {
+                ++statistics_.relabels;
+            }
+
+            void onAugmentation () {
+                ++statistics_.augmentations;
+            }
+
+            Statistics get () const {
+                return statistics_;
+            }
+        };
+
+        // Collects and also reports every finished phase to stderr.
+        class TraceStatistics: public CollectStatistics {
+        public:
+            void endPhase () {
+                CollectStatistics::endPhase();
+                std::fprintf(stderr, "phase %lld: %.6fs, pushes %lld (saturating %lld), relabels %lld, augmentations %lld\n",
+                             statistics_.phases, statistics_.phaseSeconds.back(), statistics_.pushes, statistics_.saturatingPushes,
+                             statistics_.relabels, statistics_.augmentations);
+            }
         };
 
         class Algorithm {
         public:
-            virtual TFlow getMaxFlow () {}
+            virtual ~Algorithm () {}
+
+            virtual TFlow getMaxFlow () = 0;
+
+            // Must be called after getMaxFlow, the cut is read from the final state of the solver.
+            virtual MinCut getMinCut () = 0;
+
+            // Counters gathered by the last getMaxFlow, empty unless the engine collects them.
+            virtual Statistics getStatistics () const {
+                return Statistics();
+            }
+        };
+
+        // Relabel to front is a single phase, its pushes and relabels are counted.
+        // Buffers of RelabelToFront, passed from one solver to the next one they keep their memory.
+        struct RelabelToFrontWorkspace {
+            std::vector<TFlow> overcrowding;
+            std::vector<int> h;
+            std::vector<Network::EdgeIterator> ptr;
         };
 
-        class RelabelToFront: public Algorithm {
+        template <class TStatisticsPolicy>
+        class BasicRelabelToFront: public Algorithm {
         private:
             Network& network_;
             TVertex vertexNumber_;
-            std::vector<TFlow> overcrowding_;
-            std::vector<int> h_;
-            std::vector<Network::EdgeIterator> ptr_;
+            RelabelToFrontWorkspace workspace_;
+            std::vector<TFlow>& overcrowding_;
+            std::vector<int>& h_;
+            std::vector<Network::EdgeIterator>& ptr_;
+            TStatisticsPolicy statistics_;
+            bool released_;
+            bool solved_;
+
+            typedef std::priority_queue<std::pair<int, TVertex>, std::vector<std::pair<int, TVertex> >,
+                                        std::greater<std::pair<int, TVertex> > > LoweredQueue;
+
+            void checkNotReleased () const {
+                if (released_) {
+                    throw ReleasedWorkspaceException();
+                }
+            }
 
             TFlow minTFlow (const TFlow& a, const TFlow& b) const {
                 return (a < b ? a : b);
             }
 
-            void push (Network::EdgeIterator edge) {
+            void push (Network::EdgeIterator edge, std::queue<TVertex>* active) {
                 TFlow flow = minTFlow(edge.getResidualCapacity(), static_cast<TFlow>(overcrowding_[edge.getStart()]));
                 edge.changeFlow(flow);
                 edge.changeReversedFlow(-flow);
                 overcrowding_[edge.getStart()] -= flow;
                 overcrowding_[edge.getFinish()] += flow;
+                statistics_.onPush(edge.getResidualCapacity() == static_cast<TFlow>(0));
+                if (active != nullptr) {
+                    activate(edge.getFinish(), flow, *active);
+                }
+            }
+
+            // A vertex is queued when it gets excess, a discharged vertex has none left, so each active vertex is queued once.
+            void activate (TVertex curVertex, TFlow received, std::queue<TVertex>& active) {
+                if (curVertex != network_.getSource() && curVertex != network_.getSink() && received > static_cast<TFlow>(0)
+                    && overcrowding_[curVertex] == received) {
+                    active.push(curVertex);
+                }
+            }
+
+            // Restores h[start] <= h[finish] + 1 on a residual arc: the start is lowered to h[finish] + 1,
+            // or, for the source, which keeps height V, the arc is saturated.
+            void repairArc (Network::EdgeIterator edge, LoweredQueue& lowered, std::queue<TVertex>& active) {
+                TVertex start = edge.getStart(), finish = edge.getFinish();
+                if (edge.getResidualCapacity() <= static_cast<TFlow>(0) || h_[start] <= h_[finish] + 1) {
+                    return;
+                }
+                if (start == network_.getSource()) {
+                    TFlow flow = edge.getResidualCapacity();
+                    edge.changeFlow(flow);
+                    edge.changeReversedFlow(-flow);
+                    overcrowding_[start] -= flow;
+                    overcrowding_[finish] += flow;
+                    statistics_.onPush(true);
+                    activate(finish, flow, active);
+                    return;
+                }
+                h_[start] = h_[finish] + 1;
+                ptr_[start] = network_.getEdgeListBegin(start);
+                lowered.push(std::make_pair(h_[start], start));
+            }
+
+            // The labels of the previous solve stay valid on every arc whose residual capacity did not grow,
+            // and the network touched every other one. Lowering a vertex can break only the residual arcs into it,
+            // so the repair spreads backwards, lowest label first, over the vertices it lowers.
+            // Only the excess it creates is then discharged, from a FIFO queue of active vertices.
+            void resolve () {
+                LoweredQueue lowered;
+                std::queue<TVertex> active;
+                const std::vector<int>& touched = network_.getTouchedEdges();
+                for (size_t i = 0; i < touched.size(); ++i) {
+                    repairArc(network_.getEdge(touched[i]), lowered, active);
+                    repairArc(network_.getEdge(touched[i] ^ 1), lowered, active);
+                }
+                while (!lowered.empty()) {
+                    TVertex curVertex = lowered.top().second;
+                    int height = lowered.top().first;
+                    lowered.pop();
+                    if (height != h_[curVertex]) {
+                        continue;
+                    }
+                    for (Network::EdgeIterator edge = network_.getEdgeListBegin(curVertex); edge.isValid(); edge.next()) {
+                        repairArc(network_.getEdge(edge.getIndex() ^ 1), lowered, active);
+                    }
+                }
+                while (!active.empty()) {
+                    TVertex curVertex = active.front();
+                    active.pop();
+                    discharge(curVertex, &active);
+                }
             }
 
             void relabel (TVertex curVertex) {
@@ -209,16 +725,17 @@ namespace NFlow {
                     }
                 }
                 h_[curVertex] = minHeight + 1;
+                statistics_.onRelabel();
             }
 
-            void discharge (TVertex curVertex) {
+            void discharge (TVertex curVertex, std::queue<TVertex>* active) {
                 while (overcrowding_[curVertex] > static_cast<TFlow>(0)) {
                     if (!ptr_[curVertex].isValid()) {
                         relabel(curVertex);
                         ptr_[curVertex] = network_.getEdgeListBegin(curVertex);
                     } else {
                         if (ptr_[curVertex].getResidualCapacity() > static_cast<TFlow>(0) && h_[curVertex] == h_[ptr_[curVertex].getFinish()] + 1) {
-                            push(ptr_[curVertex]);
+                            push(ptr_[curVertex], active);
                         } else {
                             ptr_[curVertex].next();
                         }
@@ -227,8 +744,16 @@ namespace NFlow {
             }
 
         public:
-            RelabelToFront (Network& network): network_(network), vertexNumber_(network.getVertexNumber()),
-                                               overcrowding_(vertexNumber_, static_cast<TFlow>(0)), h_(vertexNumber_, 0) {
+            // Starts from the flow already in the network with fresh labels. Calling getMaxFlow again after
+            // changeCapacity, addOrEdge or addEdge re-solves from the labels of the previous call and looks only at
+            // the edges the network touched, so its cost follows the change, not the graph; the network must not
+            // be changed in any other way (another solver, resetFlow, setTerminals) in between.
+            BasicRelabelToFront (Network& network, RelabelToFrontWorkspace&& workspace = RelabelToFrontWorkspace()):
+                    network_(network), vertexNumber_(network.getVertexNumber()), workspace_(std::move(workspace)),
+                    overcrowding_(workspace_.overcrowding), h_(workspace_.h), ptr_(workspace_.ptr), released_(false), solved_(false) {
+                overcrowding_.assign(vertexNumber_, static_cast<TFlow>(0));
+                h_.assign(vertexNumber_, 0);
+                ptr_.clear();
                 h_[network.getSource()] = vertexNumber_;
 
                 TVertex source = network_.getSource();
@@ -238,7 +763,7 @@ namespace NFlow {
                 }
 
                 for (Network::EdgeIterator edge = network.getEdgeListBegin(source); edge.isValid(); edge.next()) {
-                    TFlow flow = edge.getCapacity();
+                    TFlow flow = edge.getResidualCapacity();
                     overcrowding_[edge.getStart()] -= flow;
                     overcrowding_[edge.getFinish()] += flow;
                     edge.changeFlow(flow);
@@ -246,7 +771,20 @@ namespace NFlow {
                 }
             }
 
+            // The reference members point into workspace_, so a copy would share or outlive the buffers.
+            BasicRelabelToFront (const BasicRelabelToFront&) = delete;
+
+            BasicRelabelToFront& operator = (const BasicRelabelToFront&) = delete;
+
             TFlow getMaxFlow () {
+                checkNotReleased();
+                statistics_.beginPhase();
+                if (solved_) {
+                    resolve();
+                    network_.clearTouchedEdges();
+                    statistics_.endPhase();
+                    return network_.getFlow();
+                }
                 std::list<TVertex> vertexList;
                 for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
                     if (curVertex != network_.getSource() && curVertex != network_.getSink()) {
@@ -257,7 +795,7 @@ namespace NFlow {
                 while (listIterator != vertexList.end()) {
                     TVertex curVertex = *listIterator;
                     int oldHeight = h_[curVertex];
-                    discharge(curVertex);
+                    discharge(curVertex, nullptr);
                     if (h_[curVertex] > oldHeight) {
                         vertexList.erase(listIterator);
                         vertexList.push_front(curVertex);
@@ -265,30 +803,111 @@ namespace NFlow {
                     }
                     listIterator++;
                 }
+                solved_ = true;
+                network_.clearTouchedEdges();
+                statistics_.endPhase();
                 return network_.getFlow();
             }
+
+            Statistics getStatistics () const {
+                return statistics_.get();
+            }
+
+            // Leaves the solver unusable, the buffers go to the constructor of the next one;
+            // any later getMaxFlow, getMinCut or releaseWorkspace call throws ReleasedWorkspaceException.
+            RelabelToFrontWorkspace releaseWorkspace () {
+                checkNotReleased();
+                released_ = true;
+                return std::move(workspace_);
+            }
+
+            // Heights below V form a valid labeling without excess, so some height k < V is empty
+            // and the vertices above it can not reach the sink through residual edges.
+            MinCut getMinCut () {
+                checkNotReleased();
+                std::vector<int> heightCount(vertexNumber_, 0);
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    if (h_[curVertex] < vertexNumber_) {
+                        ++heightCount[h_[curVertex]];
+                    }
+                }
+                int gap = 1;
+                while (heightCount[gap] > 0) {
+                    ++gap;
+                }
+                std::vector<bool> sourceSide(vertexNumber_);
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    sourceSide[curVertex] = h_[curVertex] > gap;
+                }
+                return network_.getCut(std::move(sourceSide));
+            }
         };
 
-        class MalCumMah: public Algorithm {
+        typedef BasicRelabelToFront<NoStatistics> RelabelToFront;
+
+        // Buffers of MalCumMah, passed from one solver to the next one they keep their memory.
+        struct MalCumMahWorkspace {
+            std::vector<TFlow> inPotential, outPotential;
+            std::vector<int> distance;
+            std::vector<Network::EdgeIterator> ptr;
+            IndexedHeap<TFlow> potentialHeap;
+            std::vector<int> outBegin, inBegin, outArcs, inArcs, outPtr, inPtr;
+            std::vector<TFlow> flowChange;
+            std::vector<TVertex> vertexQueue;
+
+            MalCumMahWorkspace (): potentialHeap(0) {}
+        };
+
+        // A phase is one BFS layering together with its blocking flow, every reference node step is an augmentation.
+        template <class TStatisticsPolicy>
+        class BasicMalCumMah: public Algorithm {
         private:
             Network& network_;
             TVertex vertexNumber_;
             TVertex source_, sink_;
-            std::vector<TFlow> inPotential_;
-            std::vector<TFlow> outPotential_;
-            std::vector<int> distance_;
-            std::vector<Network::EdgeIterator> ptr_;
-            std::vector<Network::EdgeIterator> ptrStraight_;
-            std::vector<Network::EdgeIterator> ptrReversed_;
-
+            MalCumMahWorkspace workspace_;
+            std::vector<TFlow>& inPotential_;
+            std::vector<TFlow>& outPotential_;
+            std::vector<int>& distance_;
+            std::vector<Network::EdgeIterator>& ptr_;
+            IndexedHeap<TFlow>& potentialHeap_;
+            TStatisticsPolicy statistics_;
+
+            // The layered network of the phase: edge indices of the arcs from level d to level d + 1,
+            // bucketed by their start in outArcs_ and by their finish in inArcs_.
+            std::vector<int>& outBegin_;
+            std::vector<int>& inBegin_;
+            std::vector<int>& outArcs_;
+            std::vector<int>& inArcs_;
+            std::vector<int>& outPtr_;
+            std::vector<int>& inPtr_;
+
+            // Workspaces of the pushes and the pulls, flowChange_ is zero outside of makeFlowChangingIteration.
+            std::vector<TFlow>& flowChange_;
+            std::vector<TVertex>& vertexQueue_;
+            bool released_;
+
+            void checkNotReleased () const {
+                if (released_) {
+                    throw ReleasedWorkspaceException();
+                }
+            }
 
             TFlow minTFlow (TFlow a, TFlow b) const {
                 return (a < b ? a : b);
             }
 
+            void refreshPotential (TVertex curVertex) {
+                if (potentialHeap_.contains(curVertex)) {
+                    potentialHeap_.setKey(curVertex, getVertexPotential(curVertex));
+                }
+            }
+
             void changePotentials (TVertex start, TVertex finish, TFlow change) {
                 inPotential_[start] -= change;
                 outPotential_[finish] -= change;
+                refreshPotential(start);
+                refreshPotential(finish);
             }
 
             TFlow getVertexPotential (TVertex curVertex) const {
@@ -306,95 +925,141 @@ namespace NFlow {
                     distance_[i] = INF;
                 }
                 distance_[source_] = 0;
-                std::queue<TVertex> vertexIndexQ;
-                vertexIndexQ.push(source_);
-                while (!vertexIndexQ.empty()) {
-                    TVertex curVertex = vertexIndexQ.front();
-                    vertexIndexQ.pop();
+                int head = 0, tail = 0;
+                vertexQueue_[tail++] = source_;
+                while (head < tail) {
+                    TVertex curVertex = vertexQueue_[head++];
                     for (Network::EdgeIterator edge = ptr_[curVertex]; edge.isValid(); edge.next()) {
                         if (edge.getResidualCapacity() > static_cast<TFlow>(0) && distance_[edge.getFinish()] == INF) {
                             distance_[edge.getFinish()] = distance_[curVertex] + 1;
-                            vertexIndexQ.push(edge.getFinish());
+                            vertexQueue_[tail++] = edge.getFinish();
                         }
                     }
                 }
                 return distance_[sink_] != INF;
             }
 
-            void makeFlowChangingIteration (TVertex referenceVertex, TFlow potential, TVertex endVertex, std::vector<Network::EdgeIterator>& edgePtr_, bool straight) {
-                std::queue<TVertex> vertexIndexQ;
-                vertexIndexQ.push(referenceVertex);
-                std::vector<TFlow> flowChange(vertexNumber_, static_cast<TFlow>(0));
-                flowChange[referenceVertex] = potential;
-                while (!vertexIndexQ.empty()) {
-                    TVertex curVertex = vertexIndexQ.front();
-                    vertexIndexQ.pop();
-                    for (; edgePtr_[curVertex].isValid(); edgePtr_[curVertex].next()) {
-                        Network::EdgeIterator edge = edgePtr_[curVertex];
-                        if (distance_[curVertex] != distance_[edge.getFinish()] + 1 && !straight) {
-                            continue;
-                        }
-                        if (distance_[edge.getFinish()] != distance_[curVertex] + 1 && straight) {
-                            continue;
-                        }
-                        if (flowChange[curVertex] == static_cast<TFlow>(0)) {
-                            break;
+            // Only the vertices closer to the source than the sink (and the sink itself) can lie on a shortest path.
+            bool isLayered (TVertex curVertex) const {
+                return distance_[curVertex] < distance_[sink_] || curVertex == sink_;
+            }
+
+            bool isLayeredArc (Network::EdgeIterator edge) const {
+                return edge.getResidualCapacity() > static_cast<TFlow>(0) && isLayered(edge.getFinish())
+                       && distance_[edge.getFinish()] == distance_[edge.getStart()] + 1;
+            }
+
+            // Two counting sort passes over the residual network, the first one also counts the potentials.
+            void buildLayeredNetwork () {
+                std::fill(outBegin_.begin(), outBegin_.end(), 0);
+                std::fill(inBegin_.begin(), inBegin_.end(), 0);
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    inPotential_[curVertex] = static_cast<TFlow>(0);
+                    outPotential_[curVertex] = static_cast<TFlow>(0);
+                }
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    if (!isLayered(curVertex)) {
+                        continue;
+                    }
+                    for (Network::EdgeIterator edge = ptr_[curVertex]; edge.isValid(); edge.next()) {
+                        if (isLayeredArc(edge)) {
+                            ++outBegin_[curVertex + 1];
+                            ++inBegin_[edge.getFinish() + 1];
+                            outPotential_[curVertex] += edge.getResidualCapacity();
+                            inPotential_[edge.getFinish()] += edge.getResidualCapacity();
                         }
-                        TFlow canChange;
-                        if (straight) {
-                            canChange = minTFlow(edge.getResidualCapacity(), flowChange[curVertex]);
-                        } else {
-                            canChange = minTFlow(edge.getReversedResCap(), flowChange[curVertex]);
+                    }
+                }
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    outBegin_[curVertex + 1] += outBegin_[curVertex];
+                    inBegin_[curVertex + 1] += inBegin_[curVertex];
+                }
+                std::copy(outBegin_.begin(), outBegin_.end() - 1, outPtr_.begin());
+                std::copy(inBegin_.begin(), inBegin_.end() - 1, inPtr_.begin());
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    if (!isLayered(curVertex)) {
+                        continue;
+                    }
+                    for (Network::EdgeIterator edge = ptr_[curVertex]; edge.isValid(); edge.next()) {
+                        if (isLayeredArc(edge)) {
+                            outArcs_[outPtr_[curVertex]++] = edge.getIndex();
+                            inArcs_[inPtr_[edge.getFinish()]++] = edge.getIndex();
                         }
-                        if (canChange == 0) {
+                    }
+                }
+                std::copy(outBegin_.begin(), outBegin_.end() - 1, outPtr_.begin());
+                std::copy(inBegin_.begin(), inBegin_.end() - 1, inPtr_.begin());
+            }
+
+            // straight pushes along outArcs_ towards the sink, otherwise pulls along inArcs_ from the source.
+            void makeFlowChangingIteration (TVertex referenceVertex, TFlow potential, TVertex endVertex, bool straight) {
+                const std::vector<int>& arcs = straight ? outArcs_ : inArcs_;
+                const std::vector<int>& arcEnd = straight ? outBegin_ : inBegin_;
+                std::vector<int>& arcPtr = straight ? outPtr_ : inPtr_;
+                int head = 0, tail = 0;
+                vertexQueue_[tail++] = referenceVertex;
+                flowChange_[referenceVertex] = potential;
+                while (head < tail) {
+                    TVertex curVertex = vertexQueue_[head++];
+                    for (; arcPtr[curVertex] < arcEnd[curVertex + 1]; ++arcPtr[curVertex]) {
+                        Network::EdgeIterator edge = network_.getEdge(arcs[arcPtr[curVertex]]);
+                        TVertex nextVertex = straight ? edge.getFinish() : edge.getStart();
+                        if (distance_[nextVertex] == INF) {
                             continue;
                         }
-                        if (flowChange[edge.getFinish()] == static_cast<TFlow>(0) && edge.getFinish() != endVertex) {
-                           vertexIndexQ.push(edge.getFinish());
+                        TFlow canChange = minTFlow(edge.getResidualCapacity(), flowChange_[curVertex]);
+                        if (canChange == static_cast<TFlow>(0)) {
+                            continue;
                         }
-                        if (straight) {
-                            edge.changeFlow(canChange);
-                            edge.changeReversedFlow(-canChange);
-                            flowChange[curVertex] -= canChange;
-                            flowChange[edge.getFinish()] += canChange;
-                            changePotentials(edge.getFinish(), curVertex, canChange);
-
-                        } else {
-                            edge.changeFlow(-canChange);
-                            edge.changeReversedFlow(canChange);
-                            flowChange[curVertex] -= canChange;
-                            flowChange[edge.getFinish()] += canChange;
-                            changePotentials(curVertex, edge.getFinish(), canChange);
+                        if (flowChange_[nextVertex] == static_cast<TFlow>(0) && nextVertex != endVertex) {
+                            vertexQueue_[tail++] = nextVertex;
                         }
-                        if (flowChange[curVertex] == static_cast<TFlow>(0)) {
+                        edge.changeFlow(canChange);
+                        edge.changeReversedFlow(-canChange);
+                        statistics_.onPush(edge.getResidualCapacity() == static_cast<TFlow>(0));
+                        flowChange_[curVertex] -= canChange;
+                        flowChange_[nextVertex] += canChange;
+                        changePotentials(edge.getFinish(), edge.getStart(), canChange);
+                        if (flowChange_[curVertex] == static_cast<TFlow>(0)) {
                             break;
                         }
                     }
                 }
+                flowChange_[endVertex] = static_cast<TFlow>(0);
             }
 
             void pullFromSource (TVertex referenceVertex, TFlow potential) {
-                makeFlowChangingIteration(referenceVertex, potential, source_, ptrReversed_, false);
+                makeFlowChangingIteration(referenceVertex, potential, source_, false);
             }
 
             void pushTowardsSink (TVertex referenceVertex, TFlow potential) {
-                makeFlowChangingIteration(referenceVertex, potential, sink_, ptrStraight_, true);
+                makeFlowChangingIteration(referenceVertex, potential, sink_, true);
             }
 
+            // The layered vertices are kept in potentialHeap_ keyed by their potentials, so this is O(1)
+            // and every potential change costs O(log V).
             TVertex referenceNode () const {
-                TFlow minPotential = INF;
-                TVertex minPotentialVertex = INF;
+                if (potentialHeap_.empty()) {
+                    return INF;
+                }
+                return potentialHeap_.top();
+            }
 
-                for (TVertex curVertex = static_cast<TFlow>(0); curVertex < vertexNumber_; ++curVertex) {
-                    if (distance_[curVertex] == INF) {
-                        continue;
+            void removeVertex (TVertex curVertex) {
+                for (int position = outPtr_[curVertex]; position < outBegin_[curVertex + 1]; ++position) {
+                    Network::EdgeIterator edge = network_.getEdge(outArcs_[position]);
+                    if (distance_[edge.getFinish()] != INF) {
+                        changePotentials(edge.getFinish(), curVertex, edge.getResidualCapacity());
                     }
-                    if (getVertexPotential(curVertex) < minPotential) {
-                        minPotential = getVertexPotential(curVertex);
-                        minPotentialVertex = curVertex;
+                }
+                for (int position = inPtr_[curVertex]; position < inBegin_[curVertex + 1]; ++position) {
+                    Network::EdgeIterator edge = network_.getEdge(inArcs_[position]);
+                    if (distance_[edge.getStart()] != INF) {
+                        changePotentials(curVertex, edge.getStart(), edge.getResidualCapacity());
                     }
                 }
-                return minPotentialVertex;
+                distance_[curVertex] = INF;
+                potentialHeap_.erase(curVertex);
             }
 
             TFlow blockingFlow () {
@@ -404,65 +1069,96 @@ namespace NFlow {
                         return static_cast<TFlow>(0);
                     }
                     if (getVertexPotential(minPotentialVertex) == static_cast<TFlow>(0)) {
-                        for (Network::EdgeIterator edge = ptr_[minPotentialVertex]; edge.isValid(); edge.next()) {
-                            if (distance_[edge.getFinish()] == distance_[minPotentialVertex] + 1) {
-                                changePotentials(edge.getFinish(), minPotentialVertex, edge.getResidualCapacity());
-                            }
-                            if (distance_[edge.getFinish()] + 1 == distance_[minPotentialVertex]) {
-                                changePotentials(minPotentialVertex, edge.getFinish(), edge.getReversedResCap());
-                            }
-                        }
-                        distance_[minPotentialVertex] = INF;
+                        removeVertex(minPotentialVertex);
                         continue;
                     }
                     TFlow change = getVertexPotential(minPotentialVertex);
                     pushTowardsSink(minPotentialVertex, change);
                     pullFromSource(minPotentialVertex, change);
+                    statistics_.onAugmentation();
                     return change;
                 }
             }
 
             void potentialInit() {
-                for (int i = 0; i < vertexNumber_; ++i) {
-                    inPotential_[i] = static_cast<TFlow>(0);
-                    outPotential_[i] = static_cast<TFlow>(0);
-                }
+                potentialHeap_.clear();
+                buildLayeredNetwork();
                 for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
-                    for (Network::EdgeIterator edge = network_.getEdgeListBegin(curVertex); edge.isValid(); edge.next()) {
-                        if (distance_[edge.getFinish()] == distance_[curVertex] + 1) {
-                            changePotentials(edge.getFinish(), curVertex, -edge.getResidualCapacity());
-                        }
+                    if (distance_[curVertex] != INF && isLayered(curVertex)) {
+                        potentialHeap_.setKey(curVertex, getVertexPotential(curVertex));
                     }
                 }
-
             }
 
         public:
-            MalCumMah(Network& network): network_(network), vertexNumber_(network.getVertexNumber()), source_(network_.getSource()), sink_(network_.getSink()),
-                                         inPotential_(vertexNumber_, static_cast<TFlow>(0)), outPotential_(vertexNumber_, static_cast<TFlow>(0)),
-                                         distance_(vertexNumber_, 0) {
+            BasicMalCumMah(Network& network, MalCumMahWorkspace&& workspace = MalCumMahWorkspace()):
+                    network_(network), vertexNumber_(network.getVertexNumber()), source_(network_.getSource()), sink_(network_.getSink()),
+                    workspace_(std::move(workspace)), inPotential_(workspace_.inPotential), outPotential_(workspace_.outPotential),
+                    distance_(workspace_.distance), ptr_(workspace_.ptr), potentialHeap_(workspace_.potentialHeap),
+                    outBegin_(workspace_.outBegin), inBegin_(workspace_.inBegin), outArcs_(workspace_.outArcs), inArcs_(workspace_.inArcs),
+                    outPtr_(workspace_.outPtr), inPtr_(workspace_.inPtr), flowChange_(workspace_.flowChange), vertexQueue_(workspace_.vertexQueue),
+                    released_(false) {
+                inPotential_.assign(vertexNumber_, static_cast<TFlow>(0));
+                outPotential_.assign(vertexNumber_, static_cast<TFlow>(0));
+                distance_.assign(vertexNumber_, 0);
+                potentialHeap_.resize(vertexNumber_);
+                outBegin_.resize(vertexNumber_ + 1);
+                inBegin_.resize(vertexNumber_ + 1);
+                outArcs_.resize(network.getEdgeNumber());
+                inArcs_.resize(network.getEdgeNumber());
+                outPtr_.resize(vertexNumber_);
+                inPtr_.resize(vertexNumber_);
+                flowChange_.assign(vertexNumber_, static_cast<TFlow>(0));
+                vertexQueue_.resize(vertexNumber_);
+                ptr_.clear();
                 for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
                     ptr_.push_back(network.getEdgeListBegin(curVertex));
-                    ptrStraight_.push_back(ptr_[curVertex]);
-                    ptrReversed_.push_back(ptr_[curVertex]);
                 }
             }
 
+            // The reference members point into workspace_, so a copy would share or outlive the buffers.
+            BasicMalCumMah (const BasicMalCumMah&) = delete;
+
+            BasicMalCumMah& operator = (const BasicMalCumMah&) = delete;
+
             TFlow getMaxFlow () {
-                TFlow flow = static_cast<TFlow>(0);
-                while(bfs()) {
-                    ptrStraight_ = ptr_;
-                    ptrReversed_ = ptr_;
-                    potentialInit();
-                    TFlow deltaFlow = blockingFlow();
-                    while (deltaFlow > static_cast<TFlow>(0)) {
-                        flow += deltaFlow;
-                        deltaFlow = blockingFlow();
+                checkNotReleased();
+                while (true) {
+                    statistics_.beginPhase();
+                    if (!bfs()) {
+                        break;
                     }
+                    potentialInit();
+                    while (blockingFlow() > static_cast<TFlow>(0)) {}
+                    statistics_.endPhase();
+                }
+                return network_.getFlow();
+            }
+
+            Statistics getStatistics () const {
+                return statistics_.get();
+            }
+
+            // Leaves the solver unusable, the buffers go to the constructor of the next one;
+            // any later getMaxFlow, getMinCut or releaseWorkspace call throws ReleasedWorkspaceException.
+            MalCumMahWorkspace releaseWorkspace () {
+                checkNotReleased();
+                released_ = true;
+                return std::move(workspace_);
+            }
+
+            // The last bfs did not reach the sink, the vertices it reached form the source side.
+            MinCut getMinCut () {
+                checkNotReleased();
+                std::vector<bool> sourceSide(vertexNumber_);
+                for (TVertex curVertex = static_cast<TVertex>(0); curVertex < vertexNumber_; ++curVertex) {
+                    sourceSide[curVertex] = distance_[curVertex] != INF;
                 }
-                return flow;
+                return network_.getCut(std::move(sourceSide));
             }
         };
+
+        typedef BasicMalCumMah<NoStatistics> MalCumMah;
     }
 }
 #endif
@@ -0,0 +1,793 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include "MinCostFlow.cpp"
+#include "HopcroftKarp.cpp"
+#include "NetworkIO.cpp"
+#include "BoykovKolmogorov.cpp"
+#include "GomoryHuTree.cpp"
+#include "BatchSolver.cpp"
+#include "NetworkReduction.cpp"
+#include "ParametricMaxFlow.cpp"
+#include "GlobalMinCut.cpp"
+
+using namespace NFlow::NInner;
+
+namespace {
+    struct TestArc {
+        TVertex start, finish;
+        TFlow cap;
+    };
+
+    struct TestNetwork {
+        TVertex vertexNumber, source, sink;
+        std::vector<TestArc> arcs;
+
+        void build (Network& network) const {
+            for (size_t i = 0; i < arcs.size(); ++i) {
+                network.addOrEdge(arcs[i].start, arcs[i].finish, arcs[i].cap);
+            }
+        }
+
+        void buildUndirected (Network& network) const {
+            for (size_t i = 0; i < arcs.size(); ++i) {
+                network.addEdge(arcs[i].start, arcs[i].finish, arcs[i].cap);
+            }
+        }
+    };
+
+    // Up to 9 vertices, so every cut can be enumerated; loops and parallel arcs included.
+    TestNetwork randomNetwork (std::mt19937& generator, TFlow maxCap) {
+        TestNetwork network;
+        network.vertexNumber = 2 + generator() % 8;
+        network.source = generator() % network.vertexNumber;
+        network.sink = (network.source + 1 + generator() % (network.vertexNumber - 1)) % network.vertexNumber;
+        int arcNumber = generator() % (3 * network.vertexNumber + 1);
+        for (int i = 0; i < arcNumber; ++i) {
+            TestArc arc = {static_cast<TVertex>(generator() % network.vertexNumber), static_cast<TVertex>(generator() % network.vertexNumber),
+                           static_cast<TFlow>(generator() % (maxCap + 1))};
+            network.arcs.push_back(arc);
+        }
+        return network;
+    }
+
+    // Minimum over all source sides of the capacity of the arcs leaving it; undirected arcs count in both directions.
+    TFlow bruteMinCut (const TestNetwork& network, bool undirected = false) {
+        TFlow best = std::numeric_limits<TFlow>::max();
+        for (int mask = 0; mask < (1 << network.vertexNumber); ++mask) {
+            if (!((mask >> network.source) & 1) || ((mask >> network.sink) & 1)) {
+                continue;
+            }
+            TFlow value = 0;
+            for (size_t i = 0; i < network.arcs.size(); ++i) {
+                bool startSide = (mask >> network.arcs[i].start) & 1, finishSide = (mask >> network.arcs[i].finish) & 1;
+                if ((startSide && !finishSide) || (undirected && !startSide && finishSide)) {
+                    value += network.arcs[i].cap;
+                }
+            }
+            best = std::min(best, value);
+        }
+        return best;
+    }
+
+    // Minimum over all splits of the vertices into two non-empty sides.
+    TFlow bruteGlobalMinCut (const TestNetwork& network) {
+        TFlow best = std::numeric_limits<TFlow>::max();
+        for (int mask = 1; mask < (1 << (network.vertexNumber - 1)); ++mask) {
+            TFlow value = 0;
+            for (size_t i = 0; i < network.arcs.size(); ++i) {
+                if (((mask >> network.arcs[i].start) & 1) != ((mask >> network.arcs[i].finish) & 1)) {
+                    value += network.arcs[i].cap;
+                }
+            }
+            best = std::min(best, value);
+        }
+        return best;
+    }
+
+    // The flow respects the capacities, is antisymmetric, conserved outside the terminals and has the given value.
+    void expectFeasible (Network& network, TFlow flow) {
+        std::vector<TFlow> excess(network.getVertexNumber(), 0);
+        for (int edgeIndex = 0; edgeIndex < network.getEdgeNumber(); ++edgeIndex) {
+            Network::EdgeIterator edge = network.getEdge(edgeIndex);
+            EXPECT_LE(edge.getFlow(), edge.getCapacity());
+            EXPECT_EQ(edge.getFlow(), -network.getEdge(edgeIndex ^ 1).getFlow());
+            excess[edge.getFinish()] += edge.getFlow();
+        }
+        for (TVertex curVertex = 0; curVertex < network.getVertexNumber(); ++curVertex) {
+            if (curVertex != network.getSource() && curVertex != network.getSink()) {
+                EXPECT_EQ(excess[curVertex], 0);
+            }
+        }
+        EXPECT_EQ(excess[network.getSink()], flow);
+        EXPECT_EQ(network.getFlow(), flow);
+    }
+
+    // The cut separates the terminals and its arcs, recounted from the source side, carry the given value.
+    void expectCut (const TestNetwork& network, const MinCut& cut, TFlow value) {
+        ASSERT_EQ(static_cast<TVertex>(cut.sourceSide.size()), network.vertexNumber);
+        EXPECT_TRUE(cut.sourceSide[network.source]);
+        EXPECT_FALSE(cut.sourceSide[network.sink]);
+        TFlow recounted = 0;
+        for (size_t i = 0; i < network.arcs.size(); ++i) {
+            if (cut.sourceSide[network.arcs[i].start] && !cut.sourceSide[network.arcs[i].finish]) {
+                recounted += network.arcs[i].cap;
+            }
+        }
+        EXPECT_EQ(recounted, value);
+        EXPECT_EQ(cut.value, value);
+    }
+
+    // Costs by edge index for arcs added one per call: the same cost in both directions of an addEdge pair.
+    std::vector<TCost> randomCosts (std::mt19937& generator, size_t arcNumber, bool undirected = false) {
+        std::vector<TCost> costs(2 * arcNumber, 0);
+        for (size_t i = 0; i < arcNumber; ++i) {
+            costs[2 * i] = generator() % 21;
+            costs[2 * i + 1] = undirected ? costs[2 * i] : 0;
+        }
+        return costs;
+    }
+
+    // A flow has minimum cost among the flows of its value iff the residual network has no negative cycle.
+    // Pushing along an edge with negative flow cancels the flow of its reversed edge and refunds that cost.
+    bool hasNegativeResidualCycle (Network& network, const std::vector<TCost>& costs) {
+        std::vector<TCost> distance(network.getVertexNumber(), 0);
+        for (TVertex round = 0; round <= network.getVertexNumber(); ++round) {
+            bool changed = false;
+            for (int edgeIndex = 0; edgeIndex < network.getEdgeNumber(); ++edgeIndex) {
+                Network::EdgeIterator edge = network.getEdge(edgeIndex);
+                TCost cost = edge.getFlow() < 0 ? -costs[edgeIndex ^ 1] : costs[edgeIndex];
+                if (edge.getResidualCapacity() > 0 && distance[edge.getStart()] + cost < distance[edge.getFinish()]) {
+                    distance[edge.getFinish()] = distance[edge.getStart()] + cost;
+                    changed = true;
+                }
+            }
+            if (!changed) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST(MaxFlow, enginesMatchBruteForce) {
+    std::mt19937 generator(1);
+    for (int test = 0; test < 300; ++test) {
+        TestNetwork instance = randomNetwork(generator, test % 2 == 0 ? 3 : 100);
+        TFlow expected = bruteMinCut(instance);
+        std::vector<TCost> costs = randomCosts(generator, instance.arcs.size());
+        for (int engine = 0; engine < 6; ++engine) {
+            Network network(instance.vertexNumber, instance.source, instance.sink);
+            instance.build(network);
+            std::unique_ptr<Algorithm> algorithm;
+            if (engine == 0) {
+                algorithm.reset(new RelabelToFront(network));
+            } else if (engine == 1) {
+                algorithm.reset(new MalCumMah(network));
+            } else if (engine == 2) {
+                algorithm.reset(new ParallelPushRelabel(network, 2));
+            } else if (engine == 3) {
+                algorithm.reset(new MinCostFlow(network, costs));
+            } else if (engine == 4) {
+                algorithm.reset(new MinCostFlow(network, costs, COST_SCALING));
+            } else {
+                algorithm.reset(new BipartiteMatchingAdapter(network));
+            }
+            EXPECT_EQ(algorithm->getMaxFlow(), expected) << "test " << test << " engine " << engine;
+            expectFeasible(network, expected);
+            expectCut(instance, algorithm->getMinCut(), expected);
+        }
+    }
+}
+
+TEST(ParallelPushRelabel, anyThreadNumber) {
+    std::mt19937 generator(13);
+    for (int test = 0; test < 100; ++test) {
+        TestNetwork instance = randomNetwork(generator, 50);
+        TFlow expected = bruteMinCut(instance);
+        for (size_t threadNumber = 0; threadNumber <= 4; ++threadNumber) {
+            Network network(instance.vertexNumber, instance.source, instance.sink);
+            instance.build(network);
+            EXPECT_EQ(ParallelPushRelabel(network, threadNumber).getMaxFlow(), expected) << "test " << test << " threads " << threadNumber;
+            expectFeasible(network, expected);
+        }
+    }
+}
+
+TEST(MaxFlow, resumesAfterCapacityChange) {
+    std::mt19937 generator(2);
+    for (int test = 0; test < 200; ++test) {
+        TestNetwork instance = randomNetwork(generator, 20);
+        if (instance.arcs.empty()) {
+            continue;
+        }
+        Network network(instance.vertexNumber, instance.source, instance.sink);
+        instance.build(network);
+        MalCumMah(network).getMaxFlow();
+        for (int change = 0; change < 3; ++change) {
+            size_t arc = generator() % instance.arcs.size();
+            instance.arcs[arc].cap = generator() % 21;
+            network.changeCapacity(2 * arc, instance.arcs[arc].cap);
+            TFlow expected = bruteMinCut(instance);
+            if (change % 2 == 0) {
+                EXPECT_EQ(RelabelToFront(network).getMaxFlow(), expected);
+            } else {
+                EXPECT_EQ(MalCumMah(network).getMaxFlow(), expected);
+            }
+            expectFeasible(network, expected);
+        }
+    }
+}
+
+TEST(RelabelToFront, resolvesAfterChanges) {
+    std::mt19937 generator(14);
+    for (int test = 0; test < 300; ++test) {
+        TestNetwork instance = randomNetwork(generator, 20);
+        Network network(instance.vertexNumber, instance.source, instance.sink);
+        instance.build(network);
+        RelabelToFront algorithm(network);
+        EXPECT_EQ(algorithm.getMaxFlow(), bruteMinCut(instance));
+        for (int change = 0; change < 6; ++change) {
+            if (instance.arcs.empty() || change % 3 == 2) {
+                TestArc arc = {static_cast<TVertex>(generator() % instance.vertexNumber), static_cast<TVertex>(generator() % instance.vertexNumber),
+                               static_cast<TFlow>(generator() % 21)};
+                instance.arcs.push_back(arc);
+                network.addOrEdge(arc.start, arc.finish, arc.cap);
+            } else {
+                size_t arc = generator() % instance.arcs.size();
+                instance.arcs[arc].cap = generator() % 21;
+                network.changeCapacity(2 * arc, instance.arcs[arc].cap);
+            }
+            TFlow expected = bruteMinCut(instance);
+            EXPECT_EQ(algorithm.getMaxFlow(), expected) << "test " << test << " change " << change;
+            expectFeasible(network, expected);
+            expectCut(instance, algorithm.getMinCut(), expected);
+        }
+    }
+}
+
+// Parallel source - vertex - sink paths: cutting one path and restoring it must not relabel the others.
+TEST(RelabelToFront, resolveCostFollowsTheChange) {
+    const TVertex PATH_NUMBER = 10000;
+    Network network(PATH_NUMBER + 2, PATH_NUMBER, PATH_NUMBER + 1);
+    std::vector<int> sinkEdges;
+    for (TVertex curVertex = 0; curVertex < PATH_NUMBER; ++curVertex) {
+        network.addOrEdge(PATH_NUMBER, curVertex, 1);
+        sinkEdges.push_back(network.addOrEdge(curVertex, PATH_NUMBER + 1, 1));
+    }
+    BasicRelabelToFront<CollectStatistics> algorithm(network);
+    EXPECT_EQ(algorithm.getMaxFlow(), PATH_NUMBER);
+    Statistics solved = algorithm.getStatistics();
+    network.changeCapacity(sinkEdges[5], 0);
+    EXPECT_EQ(algorithm.getMaxFlow(), PATH_NUMBER - 1);
+    network.changeCapacity(sinkEdges[5], 1);
+    EXPECT_EQ(algorithm.getMaxFlow(), PATH_NUMBER);
+    expectFeasible(network, PATH_NUMBER);
+    Statistics resolved = algorithm.getStatistics();
+    EXPECT_LE(resolved.pushes - solved.pushes, 4);
+    EXPECT_LE(resolved.relabels - solved.relabels, 2);
+}
+
+TEST(MinCostFlow, costIsMinimal) {
+    std::mt19937 generator(4);
+    for (int test = 0; test < 300; ++test) {
+        TestNetwork instance = randomNetwork(generator, 10);
+        std::vector<TCost> costs = randomCosts(generator, instance.arcs.size());
+        TCost reference = 0;
+        for (int mode = 0; mode < 3; ++mode) {
+            Network network(instance.vertexNumber, instance.source, instance.sink);
+            instance.build(network);
+            MinCostFlow minCostFlow(network, costs, mode == 0 ? SUCCESSIVE_SHORTEST_PATHS : COST_SCALING, mode == 2 ? 2 : 1);
+            EXPECT_EQ(minCostFlow.getMaxFlow(), bruteMinCut(instance));
+            EXPECT_FALSE(hasNegativeResidualCycle(network, costs)) << "test " << test << " mode " << mode;
+            if (mode == 0) {
+                reference = minCostFlow.getCost();
+            } else {
+                EXPECT_EQ(minCostFlow.getCost(), reference);
+            }
+        }
+    }
+    Network network(2, 0, 1);
+    network.addOrEdge(0, 1, 1);
+    std::vector<TCost> pairCosts(1, 0);
+    EXPECT_THROW(MinCostFlow(network, pairCosts), InvalidEdge);
+    network.addEdge(0, 1, 1);
+    std::vector<TCost> negativeCycle = {0, 0, 3, -4};
+    EXPECT_THROW(MinCostFlow(network, negativeCycle), NegativeCycleException);
+}
+
+// An undirected edge costs the same both ways, like two opposite directed arcs.
+TEST(MinCostFlow, undirectedEdgesMatchArcPairs) {
+    std::mt19937 generator(15);
+    for (int test = 0; test < 300; ++test) {
+        TestNetwork instance = randomNetwork(generator, 10);
+        std::vector<TCost> costs = randomCosts(generator, instance.arcs.size(), true);
+        TestNetwork directed = instance;
+        directed.arcs.clear();
+        std::vector<TCost> directedCosts;
+        for (size_t i = 0; i < instance.arcs.size(); ++i) {
+            directed.arcs.push_back(instance.arcs[i]);
+            directed.arcs.push_back(TestArc{instance.arcs[i].finish, instance.arcs[i].start, instance.arcs[i].cap});
+            directedCosts.insert(directedCosts.end(), {costs[2 * i], 0, costs[2 * i], 0});
+        }
+        Network reference(directed.vertexNumber, directed.source, directed.sink);
+        directed.build(reference);
+        MinCostFlow referenceFlow(reference, directedCosts);
+        TFlow expected = referenceFlow.getMaxFlow();
+        EXPECT_EQ(expected, bruteMinCut(directed));
+        for (int mode = 0; mode < 2; ++mode) {
+            Network network(instance.vertexNumber, instance.source, instance.sink);
+            instance.buildUndirected(network);
+            MinCostFlow minCostFlow(network, costs, mode == 0 ? SUCCESSIVE_SHORTEST_PATHS : COST_SCALING);
+            EXPECT_EQ(minCostFlow.getMaxFlow(), expected);
+            EXPECT_EQ(minCostFlow.getCost(), referenceFlow.getCost()) << "test " << test << " mode " << mode;
+            EXPECT_FALSE(hasNegativeResidualCycle(network, costs));
+        }
+    }
+}
+
+TEST(HopcroftKarp, matchingMatchesBruteForce) {
+    std::mt19937 generator(3);
+    for (int test = 0; test < 200; ++test) {
+        int leftNumber = 1 + generator() % 4, rightNumber = 1 + generator() % 4;
+        TestNetwork instance;
+        instance.vertexNumber = leftNumber + rightNumber + 2;
+        instance.source = instance.vertexNumber - 2;
+        instance.sink = instance.vertexNumber - 1;
+        for (int left = 0; left < leftNumber; ++left) {
+            instance.arcs.push_back(TestArc{instance.source, left, 1});
+            for (int right = 0; right < rightNumber; ++right) {
+                if (generator() % 2) {
+                    instance.arcs.push_back(TestArc{left, leftNumber + right, 1});
+                }
+            }
+        }
+        for (int right = 0; right < rightNumber; ++right) {
+            instance.arcs.push_back(TestArc{leftNumber + right, instance.sink, 1});
+        }
+        Network network(instance.vertexNumber, instance.source, instance.sink);
+        instance.build(network);
+        BipartiteMatchingAdapter adapter(network);
+        EXPECT_TRUE(adapter.isBipartite());
+        TFlow expected = bruteMinCut(instance);
+        EXPECT_EQ(adapter.getMaxFlow(), expected);
+        expectFeasible(network, expected);
+        expectCut(instance, adapter.getMinCut(), expected);
+    }
+}
+
+// Every phase augments along shortest paths only, so there are at most 2 sqrt(V) + 2 of them.
+TEST(HopcroftKarp, phasesStayWithinTheBound) {
+    std::mt19937 generator(16);
+    for (int test = 0; test < 20; ++test) {
+        int side = 200 + generator() % 800, degree = 1 + generator() % 3;
+        std::vector<std::pair<int, int> > edges;
+        for (int left = 0; left < side; ++left) {
+            // A long chain of forced alternations next to random edges.
+            edges.push_back(std::make_pair(left, left));
+            if (left + 1 < side) {
+                edges.push_back(std::make_pair(left, left + 1));
+            }
+            for (int i = 0; i < degree; ++i) {
+                edges.push_back(std::make_pair(left, static_cast<int>(generator() % side)));
+            }
+        }
+        BipartiteGraph graph(side, side, edges);
+        HopcroftKarp matcher(graph);
+        EXPECT_EQ(matcher.getMaxMatching(), side);
+        EXPECT_LE(matcher.getPhaseNumber(), 2 * std::sqrt(2.0 * side) + 2);
+        Network network(2 * side + 2, 2 * side, 2 * side + 1);
+        for (int vertex = 0; vertex < side; ++vertex) {
+            network.addOrEdge(2 * side, vertex, 1);
+            network.addOrEdge(side + vertex, 2 * side + 1, 1);
+        }
+        for (size_t i = 0; i < edges.size(); ++i) {
+            network.addOrEdge(edges[i].first, side + edges[i].second, 1);
+        }
+        EXPECT_EQ(MalCumMah(network).getMaxFlow(), side);
+    }
+}
+
+// After the first phase left 2 is free; its augmenting path through left 0 to the free right 3 is shorter
+// than the one continuing through left 1 to the free right 2, and only the shorter one may be taken.
+TEST(HopcroftKarp, augmentsShortestPathsOnly) {
+    std::vector<std::pair<int, int> > edges = {{0, 0}, {0, 1}, {0, 3}, {1, 1}, {1, 2}, {2, 0}};
+    BipartiteGraph graph(3, 4, edges);
+    HopcroftKarp matcher(graph);
+    EXPECT_EQ(matcher.getMaxMatching(), 3);
+    EXPECT_EQ(matcher.getPhaseNumber(), 2);
+    EXPECT_EQ(matcher.getMatchLeft(0), 3);
+    EXPECT_EQ(matcher.getMatchLeft(1), 1);
+    EXPECT_EQ(matcher.getMatchLeft(2), 0);
+}
+
+TEST(NetworkIO, binaryRoundTrip) {
+    std::mt19937 generator(11);
+    const std::string path = "network_io_test.bin";
+    for (int test = 0; test < 50; ++test) {
+        TestNetwork instance = randomNetwork(generator, 30);
+        Network network(instance.vertexNumber, instance.source, instance.sink);
+        instance.build(network);
+        TFlow expected = MalCumMah(network).getMaxFlow();
+        NetworkIO::writeBinary(network, path);
+        Network read = NetworkIO::readBinary(path);
+        ASSERT_EQ(read.getEdgeNumber(), network.getEdgeNumber());
+        for (int edgeIndex = 0; edgeIndex < network.getEdgeNumber(); ++edgeIndex) {
+            EXPECT_EQ(read.getEdge(edgeIndex).getStart(), network.getEdge(edgeIndex).getStart());
+            EXPECT_EQ(read.getEdge(edgeIndex).getFinish(), network.getEdge(edgeIndex).getFinish());
+            EXPECT_EQ(read.getEdge(edgeIndex).getCapacity(), network.getEdge(edgeIndex).getCapacity());
+            EXPECT_EQ(read.getEdge(edgeIndex).getFlow(), network.getEdge(edgeIndex).getFlow());
+        }
+        expectFeasible(read, expected);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(NetworkIO, corruptBinaryThrows) {
+    const std::string path = "network_io_test.bin";
+    Network network(4, 0, 3);
+    network.addOrEdge(0, 1, 5);
+    network.addOrEdge(1, 3, 4);
+    network.addOrEdge(0, 2, 2);
+    network.addOrEdge(2, 3, 9);
+    NetworkIO::writeBinary(network, path);
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    std::vector<char> bytes(1 << 12);
+    bytes.resize(std::fread(bytes.data(), 1, bytes.size(), file));
+    std::fclose(file);
+    std::mt19937 generator(12);
+    for (int test = 0; test < 500; ++test) {
+        std::vector<char> corrupt = bytes;
+        if (test % 4 == 0) {
+            corrupt.resize(generator() % corrupt.size());
+        } else {
+            corrupt[generator() % corrupt.size()] ^= static_cast<char>(1 << (generator() % 8));
+        }
+        file = std::fopen(path.c_str(), "wb");
+        std::fwrite(corrupt.data(), 1, corrupt.size(), file);
+        std::fclose(file);
+        // A flip in a capacity, the source or the sink may still give a valid network, which must then carry a feasible flow.
+        try {
+            Network read = NetworkIO::readBinary(path);
+            expectFeasible(read, read.getFlow());
+            MalCumMah(read).getMaxFlow();
+        } catch (const std::exception&) {
+        }
+    }
+    std::remove(path.c_str());
+    EXPECT_THROW(NetworkIO::readBinary(path), FileOpenException);
+}
+
+TEST(NetworkIO, dimacs) {
+    std::FILE* file = std::tmpfile();
+    std::fputs("c example\np max 4 5\nn 1 s\nn 4 t\na 1 2 5\na 1 3 2\na 2 3 3\na 2 4 4\na 3 4 9\n", file);
+    std::rewind(file);
+    Network network = NetworkIO::readDimacs(file);
+    std::fclose(file);
+    EXPECT_EQ(network.getEdgeNumber(), 10);
+    EXPECT_EQ(MalCumMah(network).getMaxFlow(), 7);
+    file = std::tmpfile();
+    std::fputs("p max 4 -1\nn 1 s\nn 4 t\na 1 2 5\n", file);
+    std::rewind(file);
+    EXPECT_THROW(NetworkIO::readDimacs(file), InvalidInputFormat);
+    std::fclose(file);
+}
+
+TEST(MaxFlow, phasesCountSuccessfulSearchesOnly) {
+    Network network(2, 0, 1);
+    BasicMalCumMah<CollectStatistics> empty(network);
+    EXPECT_EQ(empty.getMaxFlow(), 0);
+    EXPECT_EQ(empty.getStatistics().phases, 0);
+    network.addOrEdge(0, 1, 5);
+    BasicMalCumMah<CollectStatistics> single(network);
+    EXPECT_EQ(single.getMaxFlow(), 5);
+    EXPECT_EQ(single.getStatistics().phases, 1);
+    EXPECT_EQ(single.getStatistics().phaseSeconds.size(), 1u);
+}
+
+TEST(MaxFlow, statisticsFollowTheWork) {
+    std::mt19937 generator(17);
+    for (int test = 0; test < 100; ++test) {
+        TestNetwork instance = randomNetwork(generator, 20);
+        TFlow expected = bruteMinCut(instance);
+        Network first(instance.vertexNumber, instance.source, instance.sink);
+        instance.build(first);
+        BasicRelabelToFront<CollectStatistics> relabelToFront(first);
+        EXPECT_EQ(relabelToFront.getMaxFlow(), expected);
+        Statistics statistics = relabelToFront.getStatistics();
+        EXPECT_EQ(statistics.phases, 1);
+        EXPECT_EQ(statistics.phaseSeconds.size(), 1u);
+        EXPECT_GE(statistics.getNonSaturatingPushes(), 0);
+        Network second(instance.vertexNumber, instance.source, instance.sink);
+        instance.build(second);
+        BasicMalCumMah<CollectStatistics> malCumMah(second);
+        EXPECT_EQ(malCumMah.getMaxFlow(), expected);
+        statistics = malCumMah.getStatistics();
+        EXPECT_EQ(statistics.phaseSeconds.size(), static_cast<size_t>(statistics.phases));
+        EXPECT_LT(statistics.phases, instance.vertexNumber);
+        EXPECT_EQ(expected > 0, statistics.phases > 0);
+    }
+}
+
+TEST(IndexedHeap, matchesAReferenceSet) {
+    std::mt19937 generator(18);
+    const int SIZE = 50;
+    IndexedHeap<TFlow> heap(SIZE);
+    std::set<std::pair<TFlow, int> > reference;
+    std::vector<TFlow> keys(SIZE);
+    for (int step = 0; step < 20000; ++step) {
+        int item = generator() % SIZE;
+        int action = generator() % 3;
+        if (action == 0 && !reference.empty()) {
+            EXPECT_EQ(heap.getKey(heap.top()), reference.begin()->first);
+            int popped = heap.pop();
+            EXPECT_EQ(keys[popped], reference.begin()->first);
+            reference.erase(std::make_pair(keys[popped], popped));
+        } else if (action == 1 && heap.contains(item)) {
+            heap.erase(item);
+            reference.erase(std::make_pair(keys[item], item));
+        } else {
+            if (heap.contains(item)) {
+                reference.erase(std::make_pair(keys[item], item));
+            }
+            keys[item] = static_cast<TFlow>(generator() % 1000) - 500;
+            heap.setKey(item, keys[item]);
+            reference.insert(std::make_pair(keys[item], item));
+        }
+        EXPECT_EQ(heap.empty(), reference.empty());
+    }
+}
+
+// Potentials above INF were skipped by the reference node scan before the heap.
+TEST(MalCumMah, largeCapacities) {
+    std::mt19937 generator(19);
+    for (int test = 0; test < 100; ++test) {
+        TestNetwork instance = randomNetwork(generator, 20);
+        for (size_t i = 0; i < instance.arcs.size(); ++i) {
+            instance.arcs[i].cap *= static_cast<TFlow>(1000000007);
+        }
+        Network network(instance.vertexNumber, instance.source, instance.sink);
+        instance.build(network);
+        TFlow expected = bruteMinCut(instance);
+        EXPECT_EQ(MalCumMah(network).getMaxFlow(), expected) << "test " << test;
+        expectFeasible(network, expected);
+    }
+}
+
+// Levels of vertices with arcs forwards, backwards and inside a level: only the forward arcs of the current BFS
+// levels may enter the layered network of a phase.
+TEST(MalCumMah, layeredNetworksMatchRelabelToFront) {
+    std::mt19937 generator(20);
+    for (int test = 0; test < 50; ++test) {
+        int levelNumber = 2 + generator() % 8, width = 1 + generator() % 10;
+        TVertex vertexNumber = levelNumber * width + 2;
+        TVertex source = vertexNumber - 2, sink = vertexNumber - 1;
+        std::vector<TestArc> arcs;
+        for (int vertex = 0; vertex < width; ++vertex) {
+            arcs.push_back(TestArc{source, vertex, static_cast<TFlow>(generator() % 50)});
+            arcs.push_back(TestArc{(levelNumber - 1) * width + vertex, sink, static_cast<TFlow>(generator() % 50)});
+        }
+        int arcNumber = generator() % (4 * levelNumber * width);
+        for (int i = 0; i < arcNumber; ++i) {
+            int level = generator() % levelNumber;
+            int nextLevel = std::min(std::max(level + static_cast<int>(generator() % 4) - 1, 0), levelNumber - 1);
+            arcs.push_back(TestArc{level * width + static_cast<TVertex>(generator() % width), nextLevel * width + static_cast<TVertex>(generator() % width),
+                                   static_cast<TFlow>(generator() % 50)});
+        }
+        Network first(vertexNumber, source, sink), second(vertexNumber, source, sink);
+        for (size_t i = 0; i < arcs.size(); ++i) {
+            first.addOrEdge(arcs[i].start, arcs[i].finish, arcs[i].cap);
+            second.addOrEdge(arcs[i].start, arcs[i].finish, arcs[i].cap);
+        }
+        TFlow expected = RelabelToFront(first).getMaxFlow();
+        BasicMalCumMah<CollectStatistics> malCumMah(second);
+        EXPECT_EQ(malCumMah.getMaxFlow(), expected) << "test " << test;
+        expectFeasible(second, expected);
+        EXPECT_EQ(malCumMah.getMinCut().value, expected);
+        EXPECT_LT(malCumMah.getStatistics().phases, vertexNumber);
+    }
+}
+
+TEST(BoykovKolmogorov, gridMatchesBruteForce) {
+    std::mt19937 generator(5);
+    for (int test = 0; test < 200; ++test) {
+        int width = 1 + generator() % 3, height = 1 + generator() % 3, depth = test % 2 == 0 ? 1 : 2;
+        GridNetwork grid(width, height, depth);
+        TestNetwork instance;
+        instance.vertexNumber = grid.getVertexNumber() + 2;
+        instance.source = instance.vertexNumber - 2;
+        instance.sink = instance.vertexNumber - 1;
+        for (TVertex vertex = 0; vertex < grid.getVertexNumber(); ++vertex) {
+            TFlow terminal = static_cast<TFlow>(generator() % 21) - 10;
+            grid.addTerminalCapacity(vertex, std::max(terminal, static_cast<TFlow>(0)), std::max(-terminal, static_cast<TFlow>(0)));
+            if (terminal > 0) {
+                instance.arcs.push_back(TestArc{instance.source, vertex, terminal});
+            } else if (terminal < 0) {
+                instance.arcs.push_back(TestArc{vertex, instance.sink, -terminal});
+            }
+            for (int direction = 0; direction < grid.getDirectionNumber(); ++direction) {
+                if (grid.hasNeighbour(vertex, direction)) {
+                    TFlow cap = generator() % 8;
+                    grid.addEdge(vertex, direction, cap);
+                    instance.arcs.push_back(TestArc{vertex, grid.getNeighbour(vertex, direction), cap});
+                }
+            }
+        }
+        BoykovKolmogorov algorithm(grid);
+        TFlow expected = bruteMinCut(instance);
+        EXPECT_EQ(algorithm.getMaxFlow(), expected);
+        MinCut cut = algorithm.getMinCut();
+        cut.sourceSide.push_back(true);
+        cut.sourceSide.push_back(false);
+        expectCut(instance, cut, expected);
+    }
+}
+
+TEST(BoykovKolmogorov, continuesAfterRaisingCapacities) {
+    std::mt19937 generator(21);
+    for (int test = 0; test < 200; ++test) {
+        int width = 1 + generator() % 3, height = 1 + generator() % 3;
+        GridNetwork grid(width, height);
+        TestNetwork instance;
+        instance.vertexNumber = grid.getVertexNumber() + 2;
+        instance.source = instance.vertexNumber - 2;
+        instance.sink = instance.vertexNumber - 1;
+        BoykovKolmogorov algorithm(grid);
+        for (int round = 0; round < 4; ++round) {
+            for (int change = 0; change < (round == 0 ? 12 : 3); ++change) {
+                TVertex vertex = generator() % grid.getVertexNumber();
+                int direction = generator() % grid.getDirectionNumber();
+                if (change % 2 == 0) {
+                    TFlow sourceCap = generator() % 6, sinkCap = generator() % 6;
+                    grid.addTerminalCapacity(vertex, sourceCap, sinkCap);
+                    instance.arcs.push_back(TestArc{instance.source, vertex, sourceCap});
+                    instance.arcs.push_back(TestArc{vertex, instance.sink, sinkCap});
+                    algorithm.markVertex(vertex);
+                } else if (grid.hasNeighbour(vertex, direction)) {
+                    TFlow cap = generator() % 6;
+                    grid.addEdge(vertex, direction, cap);
+                    instance.arcs.push_back(TestArc{vertex, grid.getNeighbour(vertex, direction), cap});
+                    algorithm.markVertex(vertex);
+                    algorithm.markVertex(grid.getNeighbour(vertex, direction));
+                }
+            }
+            TFlow expected = bruteMinCut(instance);
+            EXPECT_EQ(algorithm.getMaxFlow(), expected) << "test " << test << " round " << round;
+            MinCut cut = algorithm.getMinCut();
+            cut.sourceSide.push_back(true);
+            cut.sourceSide.push_back(false);
+            expectCut(instance, cut, expected);
+        }
+    }
+}
+
+TEST(GomoryHuTree, allPairsMatchBruteForce) {
+    std::mt19937 generator(7);
+    for (int test = 0; test < 100; ++test) {
+        TestNetwork instance = randomNetwork(generator, 20);
+        Network network(instance.vertexNumber, instance.source, instance.sink);
+        instance.buildUndirected(network);
+        GomoryHuTree sequential(network);
+        GomoryHuTree parallel(network, 2);
+        for (TVertex first = 0; first < instance.vertexNumber; ++first) {
+            for (TVertex second = first + 1; second < instance.vertexNumber; ++second) {
+                TestNetwork pair = instance;
+                pair.source = first;
+                pair.sink = second;
+                TFlow expected = bruteMinCut(pair, true);
+                EXPECT_EQ(sequential.getMinCutValue(first, second), expected);
+                EXPECT_EQ(parallel.getMinCutValue(first, second), expected);
+            }
+        }
+    }
+}
+
+TEST(BatchSolver, matchesBruteForce) {
+    std::mt19937 generator(9);
+    std::vector<TestNetwork> instances;
+    for (int test = 0; test < 100; ++test) {
+        instances.push_back(randomNetwork(generator, 50));
+    }
+    BatchSolver solver(2);
+    for (int engine = 0; engine < 2; ++engine) {
+        std::vector<Network> networks;
+        for (size_t i = 0; i < instances.size(); ++i) {
+            networks.emplace_back(instances[i].vertexNumber, instances[i].source, instances[i].sink);
+            instances[i].build(networks.back());
+        }
+        std::vector<TFlow> flows = solver.solve(networks, engine == 0 ? BATCH_MAL_CUM_MAH : BATCH_RELABEL_TO_FRONT);
+        for (size_t i = 0; i < instances.size(); ++i) {
+            TFlow expected = bruteMinCut(instances[i]);
+            EXPECT_EQ(flows[i], expected);
+            expectFeasible(networks[i], expected);
+        }
+    }
+}
+
+TEST(MaxFlow, releasedWorkspaceThrows) {
+    Network network(3, 0, 2);
+    network.addOrEdge(0, 1, 4);
+    network.addOrEdge(1, 2, 3);
+    MalCumMah malCumMah(network);
+    EXPECT_EQ(malCumMah.getMaxFlow(), 3);
+    MalCumMah next(network, malCumMah.releaseWorkspace());
+    EXPECT_THROW(malCumMah.getMaxFlow(), ReleasedWorkspaceException);
+    EXPECT_THROW(malCumMah.getMinCut(), ReleasedWorkspaceException);
+    EXPECT_THROW(malCumMah.releaseWorkspace(), ReleasedWorkspaceException);
+    EXPECT_EQ(next.getMaxFlow(), 3);
+    RelabelToFront relabelToFront(network);
+    relabelToFront.releaseWorkspace();
+    EXPECT_THROW(relabelToFront.getMaxFlow(), ReleasedWorkspaceException);
+}
+
+TEST(NetworkReduction, keepsTheMaxFlow) {
+    std::mt19937 generator(8);
+    for (int test = 0; test < 300; ++test) {
+        TestNetwork instance = randomNetwork(generator, 15);
+        Network network(instance.vertexNumber, instance.source, instance.sink);
+        instance.build(network);
+        NetworkReduction reduction(network);
+        MalCumMah(reduction.getReducedNetwork()).getMaxFlow();
+        TFlow expected = bruteMinCut(instance);
+        EXPECT_EQ(reduction.mapFlowBack(), expected) << "test " << test;
+        expectFeasible(network, expected);
+    }
+}
+
+TEST(ParametricMaxFlow, everyLambdaMatchesBruteForce) {
+    std::mt19937 generator(10);
+    const TFlow LAMBDA_MAX = 12;
+    for (int test = 0; test < 100; ++test) {
+        TestNetwork instance = randomNetwork(generator, 10);
+        std::vector<TFlow> slopes(instance.arcs.size(), 0);
+        Network network(instance.vertexNumber, instance.source, instance.sink);
+        instance.build(network);
+        ParametricMaxFlow parametric(network);
+        for (size_t i = 0; i < instance.arcs.size(); ++i) {
+            TFlow cap = instance.arcs[i].cap, slope = 1 + generator() % 3;
+            if (instance.arcs[i].start == instance.source && instance.arcs[i].finish != instance.source) {
+                slopes[i] = slope;
+                parametric.setCapacityFunction(2 * i, [cap, slope] (TFlow lambda) { return cap + slope * lambda; });
+            } else if (instance.arcs[i].finish == instance.sink && instance.arcs[i].start != instance.sink) {
+                slopes[i] = -slope;
+                parametric.setCapacityFunction(2 * i, [cap, slope] (TFlow lambda) { return std::max(cap - slope * lambda, static_cast<TFlow>(0)); });
+            }
+        }
+        // An arc added after the constructor keeps its capacity.
+        instance.arcs.push_back(TestArc{instance.source, instance.sink, 1});
+        slopes.push_back(0);
+        network.addOrEdge(instance.source, instance.sink, 1);
+        std::vector<TFlow> expected;
+        for (TFlow lambda = 0; lambda <= LAMBDA_MAX; ++lambda) {
+            TestNetwork atLambda = instance;
+            for (size_t i = 0; i < atLambda.arcs.size(); ++i) {
+                atLambda.arcs[i].cap = std::max(atLambda.arcs[i].cap + slopes[i] * lambda, static_cast<TFlow>(0));
+            }
+            expected.push_back(bruteMinCut(atLambda));
+            EXPECT_EQ(parametric.solve(lambda).value, expected.back()) << "test " << test << " lambda " << lambda;
+        }
+        std::vector<ParametricCut> cuts = parametric.getBreakpoints(0, LAMBDA_MAX);
+        ASSERT_FALSE(cuts.empty());
+        EXPECT_EQ(cuts[0].lambda, 0);
+        for (size_t i = 0; i < cuts.size(); ++i) {
+            EXPECT_EQ(cuts[i].value, expected[cuts[i].lambda]);
+        }
+    }
+}
+
+TEST(GlobalMinCut, matchesBruteForce) {
+    std::mt19937 generator(6);
+    for (int test = 0; test < 300; ++test) {
+        TestNetwork instance = randomNetwork(generator, test % 2 == 0 ? 3 : 1000);
+        Network network(instance.vertexNumber, instance.source, instance.sink);
+        instance.buildUndirected(network);
+        TFlow expected = bruteGlobalMinCut(instance);
+        MinCut stoerWagner = StoerWagner(network).getMinCut();
+        MinCut kargerStein = KargerStein(network, 0, 2).getMinCut();
+        EXPECT_EQ(stoerWagner.value, expected) << "test " << test;
+        EXPECT_EQ(kargerStein.value, expected) << "test " << test;
+    }
+}
@@ -3,6 +3,20 @@
 #include <vector>
 #include <algorithm>
 #include <iterator>
+#include <random>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 #include <cstdio>
 #include <ext/pb_ds/assoc_container.hpp>
 #include <ext/pb_ds/tree_policy.hpp>
@@ -26,37 +40,6 @@ namespace NGeometry {
 
             Point(TCoord x, TCoord y, size_t originIndex, TPointOrigin type): x_(x), y_(y), originIndex_(originIndex), type_(type) {}
 
-            ~Point() = default;
-
-            Point(const Point& point) {
-                x_ = point.x_;
-                y_ = point.y_;
-                originIndex_ = point.originIndex_;
-                type_ = point.type_;
-            }
-
-            Point(Point&& point) {
-                x_ = point.x_;
-                y_ = point.y_;
-                originIndex_ = point.originIndex_;
-                type_ = point.type_;
-            }
-
-            Point& operator = (const Point& point) {
-                x_ = point.x_;
-                y_ = point.y_;
-                originIndex_ = point.originIndex_;
-                type_ = point.type_;
-                return *this;
-            }
-
-            void operator = (Point&& point) {
-                x_ = point.x_;
-                y_ = point.y_;
-                originIndex_ = point.originIndex_;
-                type_ = point.type_;
-            }
-
             TPointOrigin getType() const {
                 return type_;
             }
@@ -152,11 +135,6 @@ namespace NGeometry {
 
             Segment(Point s, Point f): start_(s), finish_(f) {}
 
-            Segment(const Segment& segment) {
-                start_ = segment.start_;
-                finish_ = segment.finish_;
-            }
-
             Point getStart() const {
                 return start_;
             }
@@ -269,50 +247,321 @@ namespace NGeometry {
 
         typedef tree<Segment, null_type, CompareSegments, rb_tree_tag, tree_order_statistics_node_update> indexedSet;
 
-        class Scanline {
+        // Sweep event packed into 24 bytes: the segment index for segment ends, the answer index for queries.
+        struct Event {
+            TCoord x, y;
+            unsigned index;
+            TPointOrigin type;
+
+            Point getPoint() const {
+                return Point(x, y, index, type);
+            }
+        };
+
+        // LSD radix sort of the events by (x, typeRank[type], y) with 11 bit digits, the order of ComparePoints
+        // for the rank {0, 1, 2} and of compareVerticalPoints for {0, 2, 1}. The low key is
+        // typeRank * (y range + 1) + y - min y and the high key x - min x, so only the digits the ranges need
+        // are sorted: 6 passes for 30 bit coordinates. The histograms of all the digits are counted in one pass.
+        // Falls back to std::sort when the y range is too wide to fold the type in.
+        void radixSortEvents(std::vector<Event>& events, const unsigned (&typeRank)[3]) {
+            if (events.empty()) {
+                return;
+            }
+            TCoord minX = events[0].x, maxX = events[0].x, minY = events[0].y, maxY = events[0].y;
+            for (size_t i = 1; i < events.size(); ++i) {
+                minX = std::min(minX, events[i].x);
+                maxX = std::max(maxX, events[i].x);
+                minY = std::min(minY, events[i].y);
+                maxY = std::max(maxY, events[i].y);
+            }
+            typedef unsigned long long TKey;
+            const int BITS = 11;
+            const TKey MASK = (1ULL << BITS) - 1;
+            TKey rangeX = static_cast<TKey>(maxX) - static_cast<TKey>(minX);
+            TKey rangeY = static_cast<TKey>(maxY) - static_cast<TKey>(minY);
+            if (rangeY >= std::numeric_limits<TKey>::max() / 3) {
+                std::sort(events.begin(), events.end(), [&typeRank] (const Event& e1, const Event& e2) {
+                    if (e1.x != e2.x) {
+                        return e1.x < e2.x;
+                    }
+                    if (e1.type != e2.type) {
+                        return typeRank[e1.type] < typeRank[e2.type];
+                    }
+                    return e1.y < e2.y;
+                });
+                return;
+            }
+            auto getLowKey = [&] (const Event& event) -> TKey {
+                return typeRank[event.type] * (rangeY + 1) + (static_cast<TKey>(event.y) - static_cast<TKey>(minY));
+            };
+            auto getHighKey = [&] (const Event& event) -> TKey {
+                return static_cast<TKey>(event.x) - static_cast<TKey>(minX);
+            };
+            int lowDigits = 0, highDigits = 0;
+            while (lowDigits * BITS < 64 && ((3 * (rangeY + 1) - 1) >> (lowDigits * BITS))) {
+                ++lowDigits;
+            }
+            while (highDigits * BITS < 64 && (rangeX >> (highDigits * BITS))) {
+                ++highDigits;
+            }
+            int digits = lowDigits + highDigits;
+            auto getDigit = [&] (const Event& event, int digit) -> size_t {
+                if (digit < lowDigits) {
+                    return (getLowKey(event) >> (digit * BITS)) & MASK;
+                }
+                return (getHighKey(event) >> ((digit - lowDigits) * BITS)) & MASK;
+            };
+            std::vector<std::vector<size_t> > counts(digits, std::vector<size_t>(MASK + 1, 0));
+            for (size_t i = 0; i < events.size(); ++i) {
+                TKey lowKey = getLowKey(events[i]), highKey = getHighKey(events[i]);
+                for (int digit = 0; digit < lowDigits; ++digit) {
+                    ++counts[digit][(lowKey >> (digit * BITS)) & MASK];
+                }
+                for (int digit = 0; digit < highDigits; ++digit) {
+                    ++counts[lowDigits + digit][(highKey >> (digit * BITS)) & MASK];
+                }
+            }
+            std::vector<Event> buffer(events.size());
+            for (int digit = 0; digit < digits; ++digit) {
+                if (counts[digit][getDigit(events[0], digit)] == events.size()) {
+                    continue;
+                }
+                size_t position = 0;
+                for (size_t value = 0; value <= MASK; ++value) {
+                    size_t count = counts[digit][value];
+                    counts[digit][value] = position;
+                    position += count;
+                }
+                for (size_t i = 0; i < events.size(); ++i) {
+                    buffer[counts[digit][getDigit(events[i], digit)]++] = events[i];
+                }
+                events.swap(buffer);
+            }
+        }
+
+        // Online O(log n) location for a convex polygon. The vertices of the closed chain of segments are kept
+        // counterclockwise without collinear ones; a point inside the angle at the first vertex is found in
+        // the fan of triangles from it by binary search and compared with the one edge closing its triangle.
+        // isConvex is false when the segments are not a closed chain, have turns of both signs, wind more
+        // than once or have no area; locate must not be called then.
+        class ConvexPolygon {
         public:
-            Scanline(std::vector<Segment>& polygonSegments, std::vector<Point>& querryPoints) {
-                querryPointPositions.resize(querryPoints.size());
+            ConvexPolygon(): convex_(false) {}
+
+            ConvexPolygon(const std::vector<Segment>& polygonSegments): convex_(false) {
+                std::vector<Segment> chain;
                 for (size_t i = 0; i < polygonSegments.size(); ++i) {
-                    Segment curSegment = polygonSegments[i];
-                    if (curSegment.isDot()) {
+                    if (!polygonSegments[i].isDot()) {
+                        chain.push_back(polygonSegments[i]);
+                    }
+                }
+                if (chain.size() < 3) {
+                    return;
+                }
+                int turn = 0, xSignChanges = 0;
+                for (size_t i = 0; i < chain.size(); ++i) {
+                    const Segment& next = chain[(i + 1) % chain.size()];
+                    if (!(chain[i].getFinish() == next.getStart())) {
+                        return;
+                    }
+                    Point first = getVector(chain[i]), second = getVector(next);
+                    long long cross = crossProduct(first, second);
+                    if (cross == 0) {
+                        if (first.getX() * second.getX() + first.getY() * second.getY() < 0) {
+                            return;
+                        }
                         continue;
                     }
-                    Point p1 = curSegment.getStart();
-                    Point p2 = curSegment.getFinish();
-                    p1.setType(startPoint);
-                    p2.setType(startPoint);
-                    if (ComparePoints(p2, p1)) {
-                        curSegment.rotateSegment();
+                    int sign = cross > 0 ? 1 : -1;
+                    if (turn != 0 && sign != turn) {
+                        return;
                     }
-                    if (curSegment.isHorizontal()) {
-                        handlePointHorizontal(curSegment.getStart(), startPoint);
-                        handlePointHorizontal(curSegment.getFinish(), endPoint);
-                        horizontalSegments.push_back(curSegment);
+                    turn = sign;
+                    vertices_.push_back(next.getStart());
+                }
+                if (turn == 0) {
+                    return;
+                }
+                if (turn < 0) {
+                    std::reverse(vertices_.begin(), vertices_.end());
+                }
+                std::vector<int> xSigns;
+                for (size_t i = 0; i < vertices_.size(); ++i) {
+                    TCoord dx = vertices_[(i + 1) % vertices_.size()].getX() - vertices_[i].getX();
+                    if (dx != 0) {
+                        xSigns.push_back(dx > 0 ? 1 : -1);
+                    }
+                }
+                for (size_t i = 0; i < xSigns.size(); ++i) {
+                    xSignChanges += xSigns[i] != xSigns[(i + 1) % xSigns.size()];
+                }
+                convex_ = xSignChanges <= 2;
+            }
+
+            bool isConvex() const {
+                return convex_;
+            }
+
+            TPointPosition locate(TCoord x, TCoord y) const {
+                Point point;
+                point.setX(x);
+                point.setY(y);
+                size_t size = vertices_.size();
+                long long toSecond = crossProduct(getVector(vertices_[0], vertices_[1]), getVector(vertices_[0], point));
+                long long toLast = crossProduct(getVector(vertices_[0], vertices_[size - 1]), getVector(vertices_[0], point));
+                if (toSecond == 0) {
+                    return pointOnSegment(point, Segment(vertices_[0], vertices_[1])) ? BORDER : OUTSIDE;
+                }
+                if (toLast == 0) {
+                    return pointOnSegment(point, Segment(vertices_[0], vertices_[size - 1])) ? BORDER : OUTSIDE;
+                }
+                if (toSecond < 0 || toLast > 0) {
+                    return OUTSIDE;
+                }
+                size_t low = 1, high = size - 1;
+                while (high - low > 1) {
+                    size_t middle = (low + high) / 2;
+                    if (crossProduct(getVector(vertices_[0], vertices_[middle]), getVector(vertices_[0], point)) >= 0) {
+                        low = middle;
                     } else {
-                        handlePointVertical(curSegment.getStart(), startPoint);
-                        handlePointVertical(curSegment.getFinish(), endPoint);
-                        verticalSegments.push_back(curSegment);
+                        high = middle;
                     }
                 }
-                for (size_t i = 0; i < querryPoints.size(); ++i) {
-                    Point querryPoint = querryPoints[i];
-                    querryPoint.setAnswerIndex(i);
-                    querryPoint.setType(requestPoint);
-                    querriesAndIndexes.push_back(querryPoint);
-                    pointsAndIndexes.push_back(querryPoint);
+                long long side = crossProduct(getVector(vertices_[low], vertices_[low + 1]), getVector(vertices_[low], point));
+                if (side == 0) {
+                    return BORDER;
+                }
+                return side > 0 ? INSIDE : OUTSIDE;
+            }
+
+        private:
+            std::vector<Point> vertices_;
+            bool convex_;
+
+            static Point getVector(const Point& start, const Point& finish) {
+                Point vector;
+                vector.setX(finish.getX() - start.getX());
+                vector.setY(finish.getY() - start.getY());
+                return vector;
+            }
+
+            static Point getVector(const Segment& segment) {
+                return getVector(segment.getStart(), segment.getFinish());
+            }
+        };
+
+        class Scanline {
+        public:
+            // A convex polygon is detected here and answered by ConvexPolygon, without any events.
+            Scanline(std::vector<Segment>& polygonSegments, std::vector<Point>& querryPoints): convexPolygon(polygonSegments) {
+                addEvents(polygonSegments, querryPoints);
+            }
+
+            // Several rings in one sweep: an outer ring with its holes, or several outer rings, no two of them crossing.
+            // The parity of the segments below a point is the even-odd combination of the rings, so a point inside
+            // a hole is OUTSIDE, and a point on any ring is BORDER.
+            Scanline(std::vector<std::vector<Segment> >& rings, std::vector<Point>& querryPoints) {
+                if (rings.size() == 1) {
+                    convexPolygon = ConvexPolygon(rings[0]);
                 }
-                std::sort(pointsAndIndexes.begin(), pointsAndIndexes.end(), ComparePoints);
-                std::sort(querriesAndIndexes.begin(), querriesAndIndexes.end(), compareVerticalPoints);
+                std::vector<Segment> polygonSegments;
+                for (size_t ring = 0; ring < rings.size(); ++ring) {
+                    polygonSegments.insert(polygonSegments.end(), rings[ring].begin(), rings[ring].end());
+                }
+                addEvents(polygonSegments, querryPoints);
             }
 
             std::vector<TPointPosition> solve() {
+                return solve(1);
+            }
+
+            // Strip-parallel solve with the same answers as the sequential one. Both passes are cut into strips
+            // with about the same number of events and never between two events with equal x. A strip of the
+            // first pass starts with the segments crossing its left boundary already in its tree, a strip of the
+            // second pass starts empty, since a vertical segment lives at one x only. All the strips of both
+            // passes are tasks for threadNumber threads; the vertical BORDER answers are applied at the end.
+            std::vector<TPointPosition> solve(size_t threadNumber) {
+                threadNumber = std::max(threadNumber, static_cast<size_t>(1));
+                if (convexPolygon.isConvex()) {
+                    for (size_t i = 0; i < convexQuerries.size(); ++i) {
+                        querryPointPositions[i] = convexPolygon.locate(convexQuerries[i].getX(), convexQuerries[i].getY());
+                    }
+                    return querryPointPositions;
+                }
+                std::vector<size_t> horizontalBounds = splitStrips(pointsAndIndexes, threadNumber);
+                std::vector<size_t> verticalBounds = splitStrips(querriesAndIndexes, threadNumber);
+                size_t horizontalStrips = horizontalBounds.size() - 1;
+                size_t taskNumber = horizontalStrips + verticalBounds.size() - 1;
+                std::vector<char> verticalBorder(querryPointPositions.size(), 0);
+                std::atomic<size_t> nextTask(0);
+                auto work = [&] () {
+                    for (size_t task = nextTask++; task < taskNumber; task = nextTask++) {
+                        if (task < horizontalStrips) {
+                            sweepHorizontal(horizontalBounds[task], horizontalBounds[task + 1]);
+                        } else {
+                            task -= horizontalStrips;
+                            sweepVertical(verticalBounds[task], verticalBounds[task + 1], verticalBorder);
+                        }
+                    }
+                };
+                std::vector<std::thread> threads;
+                for (size_t thread = 1; thread < std::min(threadNumber, taskNumber); ++thread) {
+                    threads.emplace_back(work);
+                }
+                work();
+                for (size_t thread = 0; thread < threads.size(); ++thread) {
+                    threads[thread].join();
+                }
+                for (size_t i = 0; i < verticalBorder.size(); ++i) {
+                    if (verticalBorder[i]) {
+                        querryPointPositions[i] = BORDER;
+                    }
+                }
+                return querryPointPositions;
+            }
+
+        private:
+            std::vector<Event> pointsAndIndexes;
+            std::vector<Event> querriesAndIndexes;
+            std::vector<Segment> horizontalSegments;
+            std::vector<Segment> verticalSegments;
+            std::vector<TPointPosition> querryPointPositions;
+            ConvexPolygon convexPolygon;
+            std::vector<Point> convexQuerries;
+
+            const TCoord INF = static_cast<TCoord> (1e9);
+
+            // Event positions cutting the sorted events into at most stripNumber strips, first 0 and last the size.
+            static std::vector<size_t> splitStrips(const std::vector<Event>& events, size_t stripNumber) {
+                std::vector<size_t> bounds(1, 0);
+                for (size_t strip = 1; strip < stripNumber; ++strip) {
+                    size_t bound = std::max(bounds.back(), events.size() * strip / stripNumber);
+                    while (bound > 0 && bound < events.size() && events[bound].x == events[bound - 1].x) {
+                        ++bound;
+                    }
+                    if (bound > bounds.back() && bound < events.size()) {
+                        bounds.push_back(bound);
+                    }
+                }
+                bounds.push_back(events.size());
+                return bounds;
+            }
+
+            void sweepHorizontal(size_t begin, size_t end) {
                 std::set<std::pair<long long, long long> > ends;
                 indexedSet activeSegments;
-                for (size_t i = 0; i < pointsAndIndexes.size(); ++i) {
-                    Point curPoint = pointsAndIndexes[i];
+                if (begin < end) {
+                    TCoord left = pointsAndIndexes[begin].x;
+                    for (size_t i = 0; i < horizontalSegments.size(); ++i) {
+                        if (horizontalSegments[i].getStart().getX() < left && left <= horizontalSegments[i].getFinish().getX()) {
+                            activeSegments.insert(horizontalSegments[i]);
+                        }
+                    }
+                }
+                for (size_t i = begin; i < end; ++i) {
+                    Point curPoint = pointsAndIndexes[i].getPoint();
                     int idx = curPoint.getAnswerIndex();
-                    if (ends.begin()->first != curPoint.getX()) {
+                    if (!ends.empty() && ends.begin()->first != curPoint.getX()) {
                         ends.clear();
                     }
                     if (curPoint.getType() == startPoint) {
@@ -347,9 +596,12 @@ namespace NGeometry {
                         querryPointPositions[idx] = OUTSIDE;
                     }
                 }
+            }
+
+            void sweepVertical(size_t begin, size_t end, std::vector<char>& verticalBorder) const {
                 std::set<Segment, CompareVerticalSegments> verticalAssistant;
-                for (size_t i = 0; i < querriesAndIndexes.size(); ++i) {
-                    Point curPoint = querriesAndIndexes[i];
+                for (size_t i = begin; i < end; ++i) {
+                    Point curPoint = querriesAndIndexes[i].getPoint();
                     int idx = curPoint.getAnswerIndex();
                     if (curPoint.getType() == startPoint) {
                         verticalAssistant.insert(verticalSegments[curPoint.getSegment()]);
@@ -367,88 +619,1081 @@ namespace NGeometry {
                         if (!verticalAssistant.empty() && botomSegment != verticalAssistant.begin()) {
                             botomSegment--;
                             if (pointOnSegment(curPoint, *botomSegment)) {
-                                querryPointPositions[idx] = BORDER;
+                                verticalBorder[idx] = 1;
                             }
                         }
                     }
                 }
-                return querryPointPositions;
             }
 
-        private:
-            std::vector<Point> pointsAndIndexes;
-            std::vector<Point> querriesAndIndexes;
-            std::vector<Segment> horizontalSegments;
-            std::vector<Segment> verticalSegments;
-            std::vector<TPointPosition> querryPointPositions;
-
-            const TCoord INF = static_cast<TCoord> (1e9);
+            void addEvents(const std::vector<Segment>& polygonSegments, const std::vector<Point>& querryPoints) {
+                querryPointPositions.resize(querryPoints.size());
+                if (convexPolygon.isConvex()) {
+                    convexQuerries = querryPoints;
+                    return;
+                }
+                for (size_t i = 0; i < polygonSegments.size(); ++i) {
+                    Segment curSegment = polygonSegments[i];
+                    if (curSegment.isDot()) {
+                        continue;
+                    }
+                    Point p1 = curSegment.getStart();
+                    Point p2 = curSegment.getFinish();
+                    p1.setType(startPoint);
+                    p2.setType(startPoint);
+                    if (ComparePoints(p2, p1)) {
+                        curSegment.rotateSegment();
+                    }
+                    if (curSegment.isHorizontal()) {
+                        handlePointHorizontal(curSegment.getStart(), startPoint);
+                        handlePointHorizontal(curSegment.getFinish(), endPoint);
+                        horizontalSegments.push_back(curSegment);
+                    } else {
+                        handlePointVertical(curSegment.getStart(), startPoint);
+                        handlePointVertical(curSegment.getFinish(), endPoint);
+                        verticalSegments.push_back(curSegment);
+                    }
+                }
+                for (size_t i = 0; i < querryPoints.size(); ++i) {
+                    Event querryEvent = {querryPoints[i].getX(), querryPoints[i].getY(), static_cast<unsigned>(i), requestPoint};
+                    querriesAndIndexes.push_back(querryEvent);
+                    pointsAndIndexes.push_back(querryEvent);
+                }
+                const unsigned horizontalRank[3] = {0, 1, 2};
+                const unsigned verticalRank[3] = {0, 2, 1};
+                radixSortEvents(pointsAndIndexes, horizontalRank);
+                radixSortEvents(querriesAndIndexes, verticalRank);
+            }
 
             void handlePointHorizontal(Point point, TPointOrigin type) {
-                point.setSegment(horizontalSegments.size());
-                point.setType(type);
-                pointsAndIndexes.push_back(point);
+                Event event = {point.getX(), point.getY(), static_cast<unsigned>(horizontalSegments.size()), type};
+                pointsAndIndexes.push_back(event);
             }
 
             void handlePointVertical(Point point, TPointOrigin type) {
-                point.setSegment(verticalSegments.size());
-                point.setType(type);
-                querriesAndIndexes.push_back(point);
+                Event event = {point.getX(), point.getY(), static_cast<unsigned>(verticalSegments.size()), type};
+                querriesAndIndexes.push_back(event);
+            }
+        };
+
+        // The BORDER answers a sweep over the non vertical segments does not give: the polygon vertices
+        // and the vertical segments, kept in sorted arrays. Call build after the last addSegment.
+        class PolygonBorder {
+        public:
+            void addSegment(const Segment& segment) {
+                vertices_.push_back(std::make_pair(segment.getStart().getX(), segment.getStart().getY()));
+                vertices_.push_back(std::make_pair(segment.getFinish().getX(), segment.getFinish().getY()));
+                if (!segment.isDot() && !segment.isHorizontal()) {
+                    VerticalSegment vertical = {segment.getStart().getX(), std::min(segment.getStart().getY(), segment.getFinish().getY()),
+                                                std::max(segment.getStart().getY(), segment.getFinish().getY())};
+                    verticalSegments_.push_back(vertical);
+                }
+            }
+
+            void build() {
+                std::sort(vertices_.begin(), vertices_.end());
+                vertices_.erase(std::unique(vertices_.begin(), vertices_.end()), vertices_.end());
+                std::sort(verticalSegments_.begin(), verticalSegments_.end(), compareVertical);
+            }
+
+            bool contains(TCoord x, TCoord y) const {
+                if (std::binary_search(vertices_.begin(), vertices_.end(), std::make_pair(x, y))) {
+                    return true;
+                }
+                VerticalSegment key = {x, y, y};
+                auto vertical = std::upper_bound(verticalSegments_.begin(), verticalSegments_.end(), key, compareVertical);
+                if (vertical == verticalSegments_.begin()) {
+                    return false;
+                }
+                --vertical;
+                return vertical->x == x && vertical->low <= y && y <= vertical->high;
+            }
+
+        private:
+            struct VerticalSegment {
+                TCoord x, low, high;
+            };
+
+            std::vector<std::pair<TCoord, TCoord> > vertices_;
+            std::vector<VerticalSegment> verticalSegments_;
+
+            static bool compareVertical(const VerticalSegment& s1, const VerticalSegment& s2) {
+                return s1.x < s2.x || (s1.x == s2.x && s1.low < s2.low);
             }
         };
+
+        // Online point location for a fixed polygon. The sweep over the non vertical segments is done once:
+        // after all the segment ends and starts at every distinct x the active segments form a new version
+        // of a persistent treap ordered bottom to top by CompareSegments, path copying keeps O(n log n) nodes.
+        // locate checks the PolygonBorder, finds the version of the query x by binary search and counts
+        // the segments below the point during one descent, so a query costs O(log n).
+        class PolygonIndex {
+        public:
+            PolygonIndex(const std::vector<Segment>& polygonSegments): generator_(polygonSegments.size()) {
+                std::vector<std::pair<TCoord, int> > ends, starts;
+                for (size_t i = 0; i < polygonSegments.size(); ++i) {
+                    Segment curSegment = polygonSegments[i];
+                    border_.addSegment(curSegment);
+                    if (curSegment.isDot() || !curSegment.isHorizontal()) {
+                        continue;
+                    }
+                    if (ComparePoints(curSegment.getFinish(), curSegment.getStart())) {
+                        curSegment.rotateSegment();
+                    }
+                    starts.push_back(std::make_pair(curSegment.getStart().getX(), segments_.size()));
+                    ends.push_back(std::make_pair(curSegment.getFinish().getX(), segments_.size()));
+                    segments_.push_back(curSegment);
+                }
+                border_.build();
+                std::sort(starts.begin(), starts.end());
+                std::sort(ends.begin(), ends.end());
+                int root = -1;
+                size_t startPos = 0, endPos = 0;
+                while (endPos < ends.size()) {
+                    TCoord x = ends[endPos].first;
+                    if (startPos < starts.size() && starts[startPos].first < x) {
+                        x = starts[startPos].first;
+                    }
+                    for (; endPos < ends.size() && ends[endPos].first == x; ++endPos) {
+                        root = erase(root, ends[endPos].second);
+                    }
+                    for (; startPos < starts.size() && starts[startPos].first == x; ++startPos) {
+                        root = insert(root, newNode(starts[startPos].second));
+                    }
+                    versionX_.push_back(x);
+                    versionRoot_.push_back(root);
+                }
+            }
+
+            TPointPosition locate(TCoord x, TCoord y) const {
+                if (border_.contains(x, y)) {
+                    return BORDER;
+                }
+                auto version = std::upper_bound(versionX_.begin(), versionX_.end(), x);
+                if (version == versionX_.begin()) {
+                    return OUTSIDE;
+                }
+                int node = versionRoot_[version - versionX_.begin() - 1];
+                size_t below = 0;
+                while (node != -1) {
+                    const Segment& curSegment = segments_[nodes_[node].segment];
+                    TCoord dx = curSegment.getFinish().getX() - curSegment.getStart().getX();
+                    TCoord dy = curSegment.getFinish().getY() - curSegment.getStart().getY();
+                    TCoord side = dx * (y - curSegment.getStart().getY()) - dy * (x - curSegment.getStart().getX());
+                    if (side == 0) {
+                        return BORDER;
+                    }
+                    if (side > 0) {
+                        below += getSize(nodes_[node].left) + 1;
+                        node = nodes_[node].right;
+                    } else {
+                        node = nodes_[node].left;
+                    }
+                }
+                return below % 2 ? INSIDE : OUTSIDE;
+            }
+
+            TPointPosition locate(const Point& point) const {
+                return locate(point.getX(), point.getY());
+            }
+
+        private:
+            struct Node {
+                int segment;
+                int left, right;
+                int size;
+                unsigned priority;
+            };
+
+            std::vector<Segment> segments_;
+            std::vector<Node> nodes_;
+            std::vector<TCoord> versionX_;
+            std::vector<int> versionRoot_;
+            PolygonBorder border_;
+            std::mt19937 generator_;
+            CompareSegments less_;
+
+            int getSize(int node) const {
+                return node == -1 ? 0 : nodes_[node].size;
+            }
+
+            int newNode(int segment) {
+                Node node = {segment, -1, -1, 1, static_cast<unsigned>(generator_())};
+                nodes_.push_back(node);
+                return nodes_.size() - 1;
+            }
+
+            // Every change goes to a copy, the nodes of the older versions are never modified.
+            int copy(int node, int left, int right) {
+                nodes_.push_back(nodes_[node]);
+                int result = nodes_.size() - 1;
+                nodes_[result].left = left;
+                nodes_[result].right = right;
+                nodes_[result].size = getSize(left) + getSize(right) + 1;
+                return result;
+            }
+
+            int merge(int first, int second) {
+                if (first == -1) {
+                    return second;
+                }
+                if (second == -1) {
+                    return first;
+                }
+                if (nodes_[first].priority > nodes_[second].priority) {
+                    int right = merge(nodes_[first].right, second);
+                    return copy(first, nodes_[first].left, right);
+                }
+                int left = merge(first, nodes_[second].left);
+                return copy(second, left, nodes_[second].right);
+            }
+
+            int insert(int node, int item) {
+                if (node == -1) {
+                    return item;
+                }
+                const Segment& segment = segments_[nodes_[item].segment];
+                if (nodes_[item].priority > nodes_[node].priority) {
+                    std::pair<int, int> parts = split(node, segment);
+                    return copy(item, parts.first, parts.second);
+                }
+                if (less_(segment, segments_[nodes_[node].segment])) {
+                    return copy(node, insert(nodes_[node].left, item), nodes_[node].right);
+                }
+                return copy(node, nodes_[node].left, insert(nodes_[node].right, item));
+            }
+
+            // Splits into the segments below the given one and the rest.
+            std::pair<int, int> split(int node, const Segment& segment) {
+                if (node == -1) {
+                    return std::make_pair(-1, -1);
+                }
+                if (less_(segments_[nodes_[node].segment], segment)) {
+                    std::pair<int, int> parts = split(nodes_[node].right, segment);
+                    return std::make_pair(copy(node, nodes_[node].left, parts.first), parts.second);
+                }
+                std::pair<int, int> parts = split(nodes_[node].left, segment);
+                return std::make_pair(parts.first, copy(node, parts.second, nodes_[node].right));
+            }
+
+            int erase(int node, int segment) {
+                if (nodes_[node].segment == segment) {
+                    return merge(nodes_[node].left, nodes_[node].right);
+                }
+                if (less_(segments_[segment], segments_[nodes_[node].segment])) {
+                    return copy(node, erase(nodes_[node].left, segment), nodes_[node].right);
+                }
+                return copy(node, nodes_[node].left, erase(nodes_[node].right, segment));
+            }
+        };
+
+        struct JoinMatch {
+            size_t point, polygon;
+            TPointPosition position;
+        };
+
+        // Spatial join of many points with many polygons in one sweep. The polygon bounding boxes are put into
+        // a uniform grid of about one cell per polygon, so a point is tested only against the polygons whose
+        // box contains it. The sweep keeps an indexedSet of active segments per polygon (segments of different
+        // polygons may cross, so they can not share one order) and a point takes the parity of the segments
+        // below it in each candidate tree. Only INSIDE and BORDER matches are reported.
+        class SpatialJoin {
+        public:
+            SpatialJoin(const std::vector<std::vector<Segment> >& polygons, const std::vector<Point>& points):
+                    segments_(polygons.size()), borders_(polygons.size()), boxes_(polygons.size()), points_(points) {
+                for (size_t polygon = 0; polygon < polygons.size(); ++polygon) {
+                    Box& box = boxes_[polygon];
+                    box.minX = box.minY = std::numeric_limits<TCoord>::max();
+                    box.maxX = box.maxY = std::numeric_limits<TCoord>::min();
+                    for (size_t i = 0; i < polygons[polygon].size(); ++i) {
+                        Segment curSegment = polygons[polygon][i];
+                        borders_[polygon].addSegment(curSegment);
+                        box.minX = std::min(box.minX, std::min(curSegment.getStart().getX(), curSegment.getFinish().getX()));
+                        box.maxX = std::max(box.maxX, std::max(curSegment.getStart().getX(), curSegment.getFinish().getX()));
+                        box.minY = std::min(box.minY, std::min(curSegment.getStart().getY(), curSegment.getFinish().getY()));
+                        box.maxY = std::max(box.maxY, std::max(curSegment.getStart().getY(), curSegment.getFinish().getY()));
+                        if (curSegment.isDot() || !curSegment.isHorizontal()) {
+                            continue;
+                        }
+                        if (ComparePoints(curSegment.getFinish(), curSegment.getStart())) {
+                            curSegment.rotateSegment();
+                        }
+                        segments_[polygon].push_back(curSegment);
+                    }
+                    borders_[polygon].build();
+                }
+                buildGrid();
+            }
+
+            // Matches sorted by point, then by polygon.
+            std::vector<JoinMatch> solve() {
+                std::vector<Event> events;
+                for (size_t polygon = 0; polygon < segments_.size(); ++polygon) {
+                    for (size_t i = 0; i < segments_[polygon].size(); ++i) {
+                        Event start = {segments_[polygon][i].getStart().getX(), startEvent, polygon, i};
+                        Event end = {segments_[polygon][i].getFinish().getX(), endEvent, polygon, i};
+                        events.push_back(start);
+                        events.push_back(end);
+                    }
+                }
+                for (size_t i = 0; i < points_.size(); ++i) {
+                    Event query = {points_[i].getX(), queryEvent, 0, i};
+                    events.push_back(query);
+                }
+                std::sort(events.begin(), events.end(), [] (const Event& e1, const Event& e2) {
+                    return e1.x < e2.x || (e1.x == e2.x && e1.type < e2.type);
+                });
+                std::vector<indexedSet> activeSegments(segments_.size());
+                std::vector<JoinMatch> matches;
+                for (size_t i = 0; i < events.size(); ++i) {
+                    const Event& curEvent = events[i];
+                    if (curEvent.type == endEvent) {
+                        activeSegments[curEvent.polygon].erase(segments_[curEvent.polygon][curEvent.index]);
+                    } else if (curEvent.type == startEvent) {
+                        activeSegments[curEvent.polygon].insert(segments_[curEvent.polygon][curEvent.index]);
+                    } else {
+                        queryCandidates(curEvent.index, activeSegments, matches);
+                    }
+                }
+                std::sort(matches.begin(), matches.end(), [] (const JoinMatch& m1, const JoinMatch& m2) {
+                    return m1.point < m2.point || (m1.point == m2.point && m1.polygon < m2.polygon);
+                });
+                return matches;
+            }
+
+        private:
+            // At equal x the segments ending there leave before the ones starting there come, then the points are asked.
+            enum TEventType{endEvent, startEvent, queryEvent};
+
+            struct Event {
+                TCoord x;
+                TEventType type;
+                size_t polygon, index;
+            };
+
+            struct Box {
+                TCoord minX, minY, maxX, maxY;
+            };
+
+            std::vector<std::vector<Segment> > segments_;
+            std::vector<PolygonBorder> borders_;
+            std::vector<Box> boxes_;
+            std::vector<Point> points_;
+
+            Box grid_;
+            TCoord cellWidth_, cellHeight_;
+            size_t gridSize_;
+            std::vector<std::vector<size_t> > cells_;
+
+            size_t getColumn(TCoord x) const {
+                return std::min(static_cast<size_t>((x - grid_.minX) / cellWidth_), gridSize_ - 1);
+            }
+
+            size_t getRow(TCoord y) const {
+                return std::min(static_cast<size_t>((y - grid_.minY) / cellHeight_), gridSize_ - 1);
+            }
+
+            void buildGrid() {
+                gridSize_ = 1;
+                while (gridSize_ * gridSize_ < boxes_.size()) {
+                    ++gridSize_;
+                }
+                grid_.minX = grid_.minY = std::numeric_limits<TCoord>::max();
+                grid_.maxX = grid_.maxY = std::numeric_limits<TCoord>::min();
+                for (size_t polygon = 0; polygon < boxes_.size(); ++polygon) {
+                    if (boxes_[polygon].minX > boxes_[polygon].maxX) {
+                        continue;
+                    }
+                    grid_.minX = std::min(grid_.minX, boxes_[polygon].minX);
+                    grid_.minY = std::min(grid_.minY, boxes_[polygon].minY);
+                    grid_.maxX = std::max(grid_.maxX, boxes_[polygon].maxX);
+                    grid_.maxY = std::max(grid_.maxY, boxes_[polygon].maxY);
+                }
+                cells_.assign(gridSize_ * gridSize_, std::vector<size_t>());
+                if (grid_.minX > grid_.maxX) {
+                    return;
+                }
+                cellWidth_ = (grid_.maxX - grid_.minX) / static_cast<TCoord>(gridSize_) + 1;
+                cellHeight_ = (grid_.maxY - grid_.minY) / static_cast<TCoord>(gridSize_) + 1;
+                for (size_t polygon = 0; polygon < boxes_.size(); ++polygon) {
+                    const Box& box = boxes_[polygon];
+                    if (box.minX > box.maxX) {
+                        continue;
+                    }
+                    for (size_t row = getRow(box.minY); row <= getRow(box.maxY); ++row) {
+                        for (size_t column = getColumn(box.minX); column <= getColumn(box.maxX); ++column) {
+                            cells_[row * gridSize_ + column].push_back(polygon);
+                        }
+                    }
+                }
+            }
+
+            void queryCandidates(size_t pointIndex, std::vector<indexedSet>& activeSegments, std::vector<JoinMatch>& matches) const {
+                const Point& curPoint = points_[pointIndex];
+                TCoord x = curPoint.getX(), y = curPoint.getY();
+                if (grid_.minX > grid_.maxX || x < grid_.minX || x > grid_.maxX || y < grid_.minY || y > grid_.maxY) {
+                    return;
+                }
+                const std::vector<size_t>& cell = cells_[getRow(y) * gridSize_ + getColumn(x)];
+                for (size_t i = 0; i < cell.size(); ++i) {
+                    size_t polygon = cell[i];
+                    const Box& box = boxes_[polygon];
+                    if (x < box.minX || x > box.maxX || y < box.minY || y > box.maxY) {
+                        continue;
+                    }
+                    JoinMatch match = {pointIndex, polygon, BORDER};
+                    if (borders_[polygon].contains(x, y)) {
+                        matches.push_back(match);
+                        continue;
+                    }
+                    Segment curSegment;
+                    curSegment.setStart(curPoint);
+                    curSegment.setFinish(curPoint);
+                    const indexedSet& active = activeSegments[polygon];
+                    auto bottomSegment = active.lower_bound(curSegment);
+                    if (bottomSegment != active.begin()) {
+                        --bottomSegment;
+                        if (pointOnSegment(curPoint, *bottomSegment)) {
+                            matches.push_back(match);
+                            continue;
+                        }
+                    }
+                    if (active.order_of_key(curSegment) % 2) {
+                        match.position = INSIDE;
+                        matches.push_back(match);
+                    }
+                }
+            }
+        };
+
+        // Brute force crossing number for small polygons: every point is tested against every segment, with
+        // the half-open x rule of the sweep for the crossings and an exact collinearity test for BORDER.
+        // Points outside the bounding box are OUTSIDE at once. When all the polygon coordinates are below
+        // 2^30 in absolute value, the differences fit into 32 bits and 4 (AVX2) or 2 (SSE4.2) points are
+        // tested at once with exact 32 x 32 -> 64 bit products; otherwise, or without the instructions,
+        // the scalar loop runs.
+        class CrossingKernel {
+        public:
+            CrossingKernel(const std::vector<Segment>& polygonSegments): minX_(std::numeric_limits<TCoord>::max()), minY_(minX_),
+                                                                         maxX_(std::numeric_limits<TCoord>::min()), maxY_(maxX_) {
+                for (size_t i = 0; i < polygonSegments.size(); ++i) {
+                    Segment curSegment = polygonSegments[i];
+                    if (curSegment.getFinish().getX() < curSegment.getStart().getX()) {
+                        curSegment.rotateSegment();
+                    }
+                    Point start = curSegment.getStart(), finish = curSegment.getFinish();
+                    x1_.push_back(start.getX());
+                    x2_.push_back(finish.getX());
+                    y1_.push_back(start.getY());
+                    yLow_.push_back(std::min(start.getY(), finish.getY()));
+                    yHigh_.push_back(std::max(start.getY(), finish.getY()));
+                    dx_.push_back(finish.getX() - start.getX());
+                    dy_.push_back(finish.getY() - start.getY());
+                    minX_ = std::min(minX_, start.getX());
+                    maxX_ = std::max(maxX_, finish.getX());
+                    minY_ = std::min(minY_, yLow_.back());
+                    maxY_ = std::max(maxY_, yHigh_.back());
+                }
+                narrow_ = !x1_.empty() && -LIMIT < minX_ && maxX_ < LIMIT && -LIMIT < minY_ && maxY_ < LIMIT;
+            }
+
+            TPointPosition locate(TCoord x, TCoord y) const {
+                if (x1_.empty() || x < minX_ || x > maxX_ || y < minY_ || y > maxY_) {
+                    return OUTSIDE;
+                }
+                bool parity = false;
+                for (size_t i = 0; i < x1_.size(); ++i) {
+                    TCoord cross = dx_[i] * (y - y1_[i]) - dy_[i] * (x - x1_[i]);
+                    if (cross == 0 && x1_[i] <= x && x <= x2_[i] && yLow_[i] <= y && y <= yHigh_[i]) {
+                        return BORDER;
+                    }
+                    parity ^= x1_[i] <= x && x < x2_[i] && cross > 0;
+                }
+                return parity ? INSIDE : OUTSIDE;
+            }
+
+            std::vector<TPointPosition> solve(const std::vector<Point>& points) const {
+                std::vector<TPointPosition> positions(points.size(), OUTSIDE);
+                std::vector<TCoord> xs, ys;
+                std::vector<size_t> indexes;
+                for (size_t i = 0; i < points.size(); ++i) {
+                    TCoord x = points[i].getX(), y = points[i].getY();
+                    if (!x1_.empty() && minX_ <= x && x <= maxX_ && minY_ <= y && y <= maxY_) {
+                        xs.push_back(x);
+                        ys.push_back(y);
+                        indexes.push_back(i);
+                    }
+                }
+                size_t done = 0;
+                std::vector<char> border(indexes.size() + 4), parity(indexes.size() + 4);
+#if defined(__x86_64__) || defined(__i386__)
+                if (narrow_ && __builtin_cpu_supports("avx2")) {
+                    done = indexes.size() / 4 * 4;
+                    solveAvx2(xs.data(), ys.data(), done, border.data(), parity.data());
+                } else if (narrow_ && __builtin_cpu_supports("sse4.2")) {
+                    done = indexes.size() / 2 * 2;
+                    solveSse42(xs.data(), ys.data(), done, border.data(), parity.data());
+                }
+#endif
+                for (size_t i = 0; i < done; ++i) {
+                    positions[indexes[i]] = border[i] ? BORDER : (parity[i] ? INSIDE : OUTSIDE);
+                }
+                for (size_t i = done; i < indexes.size(); ++i) {
+                    positions[indexes[i]] = locate(xs[i], ys[i]);
+                }
+                return positions;
+            }
+
+            size_t getSegmentNumber() const {
+                return x1_.size();
+            }
+
+        private:
+            static constexpr TCoord LIMIT = static_cast<TCoord>(1) << 30;
+
+            std::vector<TCoord> x1_, x2_, y1_, yLow_, yHigh_, dx_, dy_;
+            TCoord minX_, minY_, maxX_, maxY_;
+            bool narrow_;
+
+#if defined(__x86_64__) || defined(__i386__)
+            __attribute__((target("avx2")))
+            void solveAvx2(const TCoord* xs, const TCoord* ys, size_t count, char* border, char* parity) const {
+                const __m256i one = _mm256_set1_epi64x(1), zero = _mm256_setzero_si256();
+                for (size_t i = 0; i < count; i += 4) {
+                    __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xs + i));
+                    __m256i py = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ys + i));
+                    __m256i odd = zero, onBorder = zero;
+                    for (size_t j = 0; j < x1_.size(); ++j) {
+                        __m256i x1 = _mm256_set1_epi64x(x1_[j]), x2 = _mm256_set1_epi64x(x2_[j]);
+                        __m256i cross = _mm256_sub_epi64(_mm256_mul_epi32(_mm256_set1_epi64x(dx_[j]), _mm256_sub_epi64(py, _mm256_set1_epi64x(y1_[j]))),
+                                                         _mm256_mul_epi32(_mm256_set1_epi64x(dy_[j]), _mm256_sub_epi64(px, x1)));
+                        __m256i fromX1 = _mm256_cmpgt_epi64(_mm256_add_epi64(px, one), x1);
+                        __m256i beforeX2 = _mm256_cmpgt_epi64(x2, px);
+                        __m256i upToX2 = _mm256_cmpgt_epi64(_mm256_add_epi64(x2, one), px);
+                        __m256i inY = _mm256_and_si256(_mm256_cmpgt_epi64(_mm256_add_epi64(py, one), _mm256_set1_epi64x(yLow_[j])),
+                                                       _mm256_cmpgt_epi64(_mm256_set1_epi64x(yHigh_[j] + 1), py));
+                        odd = _mm256_xor_si256(odd, _mm256_and_si256(_mm256_and_si256(fromX1, beforeX2), _mm256_cmpgt_epi64(cross, zero)));
+                        onBorder = _mm256_or_si256(onBorder, _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi64(cross, zero), inY),
+                                                                              _mm256_and_si256(fromX1, upToX2)));
+                    }
+                    long long oddLanes[4], borderLanes[4];
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(oddLanes), odd);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(borderLanes), onBorder);
+                    for (int lane = 0; lane < 4; ++lane) {
+                        parity[i + lane] = oddLanes[lane] != 0;
+                        border[i + lane] = borderLanes[lane] != 0;
+                    }
+                }
+            }
+
+            __attribute__((target("sse4.2")))
+            void solveSse42(const TCoord* xs, const TCoord* ys, size_t count, char* border, char* parity) const {
+                const __m128i one = _mm_set1_epi64x(1), zero = _mm_setzero_si128();
+                for (size_t i = 0; i < count; i += 2) {
+                    __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(xs + i));
+                    __m128i py = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ys + i));
+                    __m128i odd = zero, onBorder = zero;
+                    for (size_t j = 0; j < x1_.size(); ++j) {
+                        __m128i x1 = _mm_set1_epi64x(x1_[j]), x2 = _mm_set1_epi64x(x2_[j]);
+                        __m128i cross = _mm_sub_epi64(_mm_mul_epi32(_mm_set1_epi64x(dx_[j]), _mm_sub_epi64(py, _mm_set1_epi64x(y1_[j]))),
+                                                      _mm_mul_epi32(_mm_set1_epi64x(dy_[j]), _mm_sub_epi64(px, x1)));
+                        __m128i fromX1 = _mm_cmpgt_epi64(_mm_add_epi64(px, one), x1);
+                        __m128i beforeX2 = _mm_cmpgt_epi64(x2, px);
+                        __m128i upToX2 = _mm_cmpgt_epi64(_mm_add_epi64(x2, one), px);
+                        __m128i inY = _mm_and_si128(_mm_cmpgt_epi64(_mm_add_epi64(py, one), _mm_set1_epi64x(yLow_[j])),
+                                                    _mm_cmpgt_epi64(_mm_set1_epi64x(yHigh_[j] + 1), py));
+                        odd = _mm_xor_si128(odd, _mm_and_si128(_mm_and_si128(fromX1, beforeX2), _mm_cmpgt_epi64(cross, zero)));
+                        onBorder = _mm_or_si128(onBorder, _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi64(cross, zero), inY),
+                                                                        _mm_and_si128(fromX1, upToX2)));
+                    }
+                    long long oddLanes[2], borderLanes[2];
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(oddLanes), odd);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(borderLanes), onBorder);
+                    for (int lane = 0; lane < 2; ++lane) {
+                        parity[i + lane] = oddLanes[lane] != 0;
+                        border[i + lane] = borderLanes[lane] != 0;
+                    }
+                }
+            }
+#endif
+        };
+
+        // Point location by a uniform grid over the polygon bounding box with about CELLS_PER_EDGE cells per edge.
+        // Every edge is listed in the cells whose closed rectangles, widened by one to the next cell corner,
+        // it touches. A cell without edges is entirely INSIDE or OUTSIDE, the state of its lower left corner.
+        // A boundary cell keeps the crossing parity of its corner and a query tests the cell edges only: the ones
+        // crossed by the downward ray inside the cell and the ones crossing the cell bottom between the corner
+        // and the query x. The corner parities are found column by column from the bottom using the cell lists.
+        // All the tests are done on the integer coordinates, so the answers are exact.
+        class GridIndex {
+        public:
+            GridIndex(const std::vector<Segment>& polygonSegments): minX_(std::numeric_limits<TCoord>::max()), minY_(minX_),
+                                                                    maxX_(std::numeric_limits<TCoord>::min()), maxY_(maxX_),
+                                                                    columns_(1), rows_(1), cellWidth_(1), cellHeight_(1) {
+                for (size_t i = 0; i < polygonSegments.size(); ++i) {
+                    Segment curSegment = polygonSegments[i];
+                    if (curSegment.isDot()) {
+                        continue;
+                    }
+                    if (curSegment.getFinish().getX() < curSegment.getStart().getX()) {
+                        curSegment.rotateSegment();
+                    }
+                    Point start = curSegment.getStart(), finish = curSegment.getFinish();
+                    Edge edge = {start.getX(), finish.getX(), start.getY(), std::min(start.getY(), finish.getY()),
+                                 std::max(start.getY(), finish.getY()), finish.getX() - start.getX(), finish.getY() - start.getY()};
+                    edges_.push_back(edge);
+                    minX_ = std::min(minX_, edge.x1);
+                    maxX_ = std::max(maxX_, edge.x2);
+                    minY_ = std::min(minY_, edge.yLow);
+                    maxY_ = std::max(maxY_, edge.yHigh);
+                }
+                if (edges_.empty()) {
+                    return;
+                }
+                buildGrid();
+            }
+
+            TPointPosition locate(TCoord x, TCoord y) const {
+                if (edges_.empty() || x < minX_ || x > maxX_ || y < minY_ || y > maxY_) {
+                    return OUTSIDE;
+                }
+                size_t cell = getRow(y) * columns_ + getColumn(x);
+                if (states_[cell] != BORDER) {
+                    return states_[cell];
+                }
+                TCoord cornerX = getColumnX(getColumn(x)), cornerY = getRowY(getRow(y));
+                bool parity = parities_[cell];
+                for (unsigned i = cellStart_[cell]; i < cellStart_[cell + 1]; ++i) {
+                    const Edge& edge = edges_[cellEdges_[i]];
+                    TCoord cross = edge.dx * (y - edge.y1) - edge.dy * (x - edge.x1);
+                    if (cross == 0 && edge.x1 <= x && x <= edge.x2 && edge.yLow <= y && y <= edge.yHigh) {
+                        return BORDER;
+                    }
+                    TCoord bottomCross = edge.dx * (cornerY - edge.y1) - edge.dy * (x - edge.x1);
+                    parity ^= edge.x1 <= x && x < edge.x2 && cross > 0 && bottomCross <= 0;
+                    if (edge.yLow < cornerY && cornerY <= edge.yHigh) {
+                        TCoord cornerCross = edge.dx * (cornerY - edge.y1) - edge.dy * (cornerX - edge.x1);
+                        bool afterCorner = cornerCross != 0 ? (cornerCross > 0) == (edge.dy > 0) : edge.dx > 0 && edge.dy < 0;
+                        bool beforePoint = bottomCross != 0 ? (bottomCross > 0) != (edge.dy > 0) : edge.dx == 0 || edge.dy > 0;
+                        parity ^= afterCorner && beforePoint;
+                    }
+                }
+                return parity ? INSIDE : OUTSIDE;
+            }
+
+            TPointPosition locate(const Point& point) const {
+                return locate(point.getX(), point.getY());
+            }
+
+            std::vector<TPointPosition> solve(const std::vector<Point>& points) const {
+                std::vector<TPointPosition> positions(points.size());
+                for (size_t i = 0; i < points.size(); ++i) {
+                    positions[i] = locate(points[i].getX(), points[i].getY());
+                }
+                return positions;
+            }
+
+            size_t getCellNumber() const {
+                return states_.size();
+            }
+
+        private:
+            static constexpr double CELLS_PER_EDGE = 4.0;
+
+            // Oriented with x1 <= x2, as in CrossingKernel.
+            struct Edge {
+                TCoord x1, x2, y1, yLow, yHigh, dx, dy;
+            };
+
+            std::vector<Edge> edges_;
+            TCoord minX_, minY_, maxX_, maxY_;
+            size_t columns_, rows_;
+            TCoord cellWidth_, cellHeight_;
+            // BORDER marks a boundary cell, which has its edges in cellEdges_[cellStart_[cell] .. cellStart_[cell + 1]).
+            std::vector<TPointPosition> states_;
+            std::vector<char> parities_;
+            std::vector<unsigned> cellStart_, cellEdges_;
+
+            size_t getColumn(TCoord x) const {
+                return std::min(static_cast<size_t>((x - minX_) / cellWidth_), columns_ - 1);
+            }
+
+            size_t getRow(TCoord y) const {
+                return std::min(static_cast<size_t>((y - minY_) / cellHeight_), rows_ - 1);
+            }
+
+            TCoord getColumnX(size_t column) const {
+                return minX_ + static_cast<TCoord>(column) * cellWidth_;
+            }
+
+            TCoord getRowY(size_t row) const {
+                return minY_ + static_cast<TCoord>(row) * cellHeight_;
+            }
+
+            static TCoord floorDiv(TCoord numerator, TCoord denominator) {
+                TCoord quotient = numerator / denominator;
+                return quotient * denominator > numerator ? quotient - 1 : quotient;
+            }
+
+            static TCoord ceilDiv(TCoord numerator, TCoord denominator) {
+                TCoord quotient = numerator / denominator;
+                return quotient * denominator < numerator ? quotient + 1 : quotient;
+            }
+
+            // Whether the downward ray from (x, y) crosses the edge, with the half open x rule of CrossingKernel.
+            static bool crossesBelow(const Edge& edge, TCoord x, TCoord y) {
+                return edge.x1 <= x && x < edge.x2 && edge.dx * (y - edge.y1) - edge.dy * (x - edge.x1) > 0;
+            }
+
+            // Calls visit(cell) for every cell the edge touches, each once. The y range of the edge over a column
+            // is rounded outwards, which can only add cells.
+            template<class TVisitor>
+            void rasterize(const Edge& edge, TVisitor visit) const {
+                size_t firstColumn = getColumn(edge.x1);
+                if (firstColumn > 0 && edge.x1 == getColumnX(firstColumn)) {
+                    --firstColumn;
+                }
+                for (size_t column = firstColumn; column <= getColumn(edge.x2); ++column) {
+                    TCoord left = std::max(edge.x1, getColumnX(column)), right = std::min(edge.x2, getColumnX(column) + cellWidth_);
+                    if (left > right) {
+                        continue;
+                    }
+                    TCoord low = edge.yLow, high = edge.yHigh;
+                    if (edge.dx != 0) {
+                        TCoord leftRise = edge.dy * (left - edge.x1), rightRise = edge.dy * (right - edge.x1);
+                        low = edge.y1 + std::min(floorDiv(leftRise, edge.dx), floorDiv(rightRise, edge.dx));
+                        high = edge.y1 + std::max(ceilDiv(leftRise, edge.dx), ceilDiv(rightRise, edge.dx));
+                    }
+                    size_t firstRow = getRow(low);
+                    if (firstRow > 0 && low == getRowY(firstRow)) {
+                        --firstRow;
+                    }
+                    for (size_t row = firstRow; row <= getRow(high); ++row) {
+                        visit(row * columns_ + column);
+                    }
+                }
+            }
+
+            void buildGrid() {
+                double width = static_cast<double>(maxX_ - minX_) + 1, height = static_cast<double>(maxY_ - minY_) + 1;
+                double cells = CELLS_PER_EDGE * static_cast<double>(edges_.size());
+                columns_ = static_cast<size_t>(std::max(1.0, std::min(width, std::sqrt(cells * width / height))));
+                rows_ = static_cast<size_t>(std::max(1.0, std::min(height, cells / static_cast<double>(columns_))));
+                cellWidth_ = (maxX_ - minX_) / static_cast<TCoord>(columns_) + 1;
+                cellHeight_ = (maxY_ - minY_) / static_cast<TCoord>(rows_) + 1;
+                size_t cellNumber = columns_ * rows_;
+                cellStart_.assign(cellNumber + 1, 0);
+                for (size_t i = 0; i < edges_.size(); ++i) {
+                    rasterize(edges_[i], [this] (size_t cell) { ++cellStart_[cell + 1]; });
+                }
+                for (size_t cell = 0; cell < cellNumber; ++cell) {
+                    cellStart_[cell + 1] += cellStart_[cell];
+                }
+                cellEdges_.resize(cellStart_[cellNumber]);
+                std::vector<unsigned> filled(cellStart_.begin(), cellStart_.end() - 1);
+                for (size_t i = 0; i < edges_.size(); ++i) {
+                    rasterize(edges_[i], [this, &filled, i] (size_t cell) { cellEdges_[filled[cell]++] = i; });
+                }
+                states_.resize(cellNumber);
+                parities_.resize(cellNumber);
+                for (size_t column = 0; column < columns_; ++column) {
+                    TCoord x = getColumnX(column);
+                    // The parity of the corner of the first row is 0: no edge is below minY_.
+                    bool corner = false;
+                    for (size_t row = 0; row < rows_; ++row) {
+                        size_t cell = row * columns_ + column;
+                        TCoord y = getRowY(row);
+                        bool upperCorner = corner;
+                        for (unsigned i = cellStart_[cell]; i < cellStart_[cell + 1]; ++i) {
+                            const Edge& edge = edges_[cellEdges_[i]];
+                            upperCorner ^= crossesBelow(edge, x, y) != crossesBelow(edge, x, y + cellHeight_);
+                        }
+                        parities_[cell] = corner;
+                        if (cellStart_[cell] == cellStart_[cell + 1]) {
+                            states_[cell] = corner ? INSIDE : OUTSIDE;
+                        } else {
+                            states_[cell] = BORDER;
+                        }
+                        corner = upperCorner;
+                    }
+                }
+            }
+        };
+
+        // Polygons up to this many segments are answered by CrossingKernel, larger ones by Scanline;
+        // with AVX2 the crossover measured by --crossover is at 200 .. 350 segments for 10^5 .. 10^6 points.
+        const size_t KERNEL_MAX_SEGMENTS = 192;
+
+        // With threadNumber 0 Scanline runs on all hardware threads from this many query points on, and on one below,
+        // where starting the threads and filling the strip trees costs more than the split sweep saves.
+        const size_t PARALLEL_MIN_POINTS = 1 << 17;
+
+        size_t getThreadNumber(size_t threadNumber, size_t pointNumber) {
+            if (threadNumber != 0) {
+                return threadNumber;
+            }
+            if (pointNumber < PARALLEL_MIN_POINTS) {
+                return 1;
+            }
+            return std::max(std::thread::hardware_concurrency(), 1u);
+        }
+
+        std::vector<TPointPosition> locatePoints(std::vector<Segment>& polygonSegments, std::vector<Point>& querryPoints,
+                                                 size_t threadNumber = 0) {
+            if (polygonSegments.size() <= KERNEL_MAX_SEGMENTS) {
+                return CrossingKernel(polygonSegments).solve(querryPoints);
+            }
+            return Scanline(polygonSegments, querryPoints).solve(getThreadNumber(threadNumber, querryPoints.size()));
+        }
+
+        std::vector<TPointPosition> locatePoints(std::vector<std::vector<Segment> >& rings, std::vector<Point>& querryPoints,
+                                                 size_t threadNumber = 0) {
+            if (rings.size() == 1) {
+                return locatePoints(rings[0], querryPoints, threadNumber);
+            }
+            size_t segmentNumber = 0;
+            for (size_t ring = 0; ring < rings.size(); ++ring) {
+                segmentNumber += rings[ring].size();
+            }
+            if (segmentNumber <= KERNEL_MAX_SEGMENTS) {
+                std::vector<Segment> polygonSegments;
+                for (size_t ring = 0; ring < rings.size(); ++ring) {
+                    polygonSegments.insert(polygonSegments.end(), rings[ring].begin(), rings[ring].end());
+                }
+                return CrossingKernel(polygonSegments).solve(querryPoints);
+            }
+            return Scanline(rings, querryPoints).solve(getThreadNumber(threadNumber, querryPoints.size()));
+        }
     }
 }
 
 #endif
 
-void readAndSolve() {
-    int tests;
-    scanf("%d", &tests);
-    for (size_t i = 0; i < tests; ++i) {
-        int numPoints;
-        scanf("%d", &numPoints);
+// The whole input in memory: mapped when it is a regular file, read in large blocks from a pipe.
+class InputBuffer {
+public:
+    InputBuffer(int fd): data_(nullptr), size_(0), position_(0), mapped_(false) {
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) == 0 && S_ISREG(fileStat.st_mode) && fileStat.st_size > 0) {
+            void* data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                madvise(data, fileStat.st_size, MADV_SEQUENTIAL);
+                data_ = static_cast<const char*>(data);
+                size_ = fileStat.st_size;
+                mapped_ = true;
+                return;
+            }
+        }
+        const size_t BLOCK = 1 << 20;
+        ssize_t got;
+        do {
+            storage_.resize(size_ + BLOCK);
+            got = read(fd, storage_.data() + size_, BLOCK);
+            size_ += std::max(got, static_cast<ssize_t>(0));
+        } while (got > 0);
+        data_ = storage_.data();
+    }
+
+    ~InputBuffer() {
+        if (mapped_) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    InputBuffer(const InputBuffer&) = delete;
+
+    InputBuffer& operator = (const InputBuffer&) = delete;
+
+    long long readInt() {
+        while (position_ < size_ && data_[position_] != '-' && (data_[position_] < '0' || data_[position_] > '9')) {
+            ++position_;
+        }
+        bool negative = position_ < size_ && data_[position_] == '-';
+        if (negative) {
+            ++position_;
+        }
+        unsigned long long value = 0;
+        while (position_ < size_ && data_[position_] >= '0' && data_[position_] <= '9') {
+            value = value * 10 + (data_[position_++] - '0');
+        }
+        return negative ? -static_cast<long long>(value) : static_cast<long long>(value);
+    }
+
+    // Little endian int64, 0 past the end.
+    long long readBinary() {
+        long long value = 0;
+        if (position_ + sizeof(value) <= size_) {
+            memcpy(&value, data_ + position_, sizeof(value));
+        }
+        position_ += sizeof(value);
+        return value;
+    }
+
+private:
+    const char* data_;
+    size_t size_, position_;
+    std::vector<char> storage_;
+    bool mapped_;
+};
+
+class OutputBuffer {
+public:
+    OutputBuffer(): size_(0) {}
+
+    ~OutputBuffer() {
+        flush();
+    }
+
+    void write(const char* data, size_t size) {
+        if (size_ + size > sizeof(buffer_)) {
+            flush();
+        }
+        if (size > sizeof(buffer_)) {
+            fwrite(data, 1, size, stdout);
+            return;
+        }
+        memcpy(buffer_ + size_, data, size);
+        size_ += size;
+    }
+
+    void flush() {
+        fwrite(buffer_, 1, size_, stdout);
+        fflush(stdout);
+        size_ = 0;
+    }
+
+private:
+    char buffer_[1 << 16];
+    size_t size_;
+};
+
+// The command line tool, left out when the library part is included by the tests.
+#ifndef SCANLINE_NO_MAIN
+
+// Text input is the format of README.md. Binary input has the same layout with every number an int64,
+// binary output is one byte per answer (0 INSIDE, 1 BORDER, 2 OUTSIDE) without test separators.
+// With printStats the number of query points per second, input and output included, goes to stderr.
+// With rings every test starts with the number of rings R, followed by R polygons in the usual N, x, y layout.
+// threadNumber goes to locatePoints, 0 picks it from the number of query points.
+void readAndSolve(bool binaryInput = false, bool binaryOutput = false, bool printStats = false, bool rings = false,
+                  size_t threadNumber = 0) {
+    auto start = std::chrono::steady_clock::now();
+    InputBuffer input(0);
+    OutputBuffer output;
+    auto readNumber = [&] () {
+        return binaryInput ? input.readBinary() : input.readInt();
+    };
+    size_t totalPoints = 0;
+    long long tests = readNumber();
+    auto readPolygon = [&] () {
+        size_t numPoints = readNumber();
         std::vector<NGeometry::NScanline::Point> points(numPoints);
-        TCoord a, b;
         for (size_t i = 0; i < numPoints; ++i) {
-            scanf("%lld %lld", &a, &b);
-            NGeometry::NScanline::Point pt;
-            pt.setX(a);
-            pt.setY(b);
-            points[i] = pt;
+            points[i].setX(readNumber());
+            points[i].setY(readNumber());
         }
         std::vector<NGeometry::NScanline::Segment> segments(numPoints);
-        for (size_t i = 0; i < numPoints - 1; ++i) {
+        for (size_t i = 0; i + 1 < numPoints; ++i) {
             segments[i].setStart(points[i]);
             segments[i].setFinish(points[i + 1]);
         }
         segments[segments.size() - 1].setStart(points.back());
         segments[segments.size() - 1].setFinish(points[0]);
-        int testPointsNum;
-        scanf("%d", &testPointsNum);
+        return segments;
+    };
+    for (long long i = 0; i < tests; ++i) {
+        std::vector<std::vector<NGeometry::NScanline::Segment> > polygon(rings ? readNumber() : 1);
+        for (size_t ring = 0; ring < polygon.size(); ++ring) {
+            polygon[ring] = readPolygon();
+        }
+        size_t testPointsNum = readNumber();
         std::vector<NGeometry::NScanline::Point> testPoints(testPointsNum);
         for (size_t i = 0; i < testPointsNum; ++i) {
-            scanf("%lld %lld", &a, &b);
-            NGeometry::NScanline::Point pt;
-            pt.setX(a);
-            pt.setY(b);
-            testPoints[i] = pt;
+            testPoints[i].setX(readNumber());
+            testPoints[i].setY(readNumber());
+        }
+        totalPoints += testPointsNum;
+        std::vector<NGeometry::NScanline::TPointPosition> ans = NGeometry::NScanline::locatePoints(polygon, testPoints, threadNumber);
+        if (binaryOutput) {
+            std::vector<char> bytes(ans.begin(), ans.end());
+            output.write(bytes.data(), bytes.size());
+            continue;
         }
-        NGeometry::NScanline::Scanline alg(segments, testPoints);
-        std::vector<NGeometry::NScanline::TPointPosition> ans = alg.solve();
         for (size_t i = 0; i < ans.size(); ++i) {
             if (ans[i] == NGeometry::NScanline::INSIDE) {
-                printf("INSIDE\n");
+                output.write("INSIDE\n", 7);
             } else if(ans[i] == NGeometry::NScanline::BORDER) {
-                printf("BORDER\n");
+                output.write("BORDER\n", 7);
             } else {
-                printf("OUTSIDE\n");
+                output.write("OUTSIDE\n", 8);
             }
         }
-        printf("\n");
+        output.write("\n", 1);
+    }
+    output.flush();
+    if (printStats) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        fprintf(stderr, "%zu points in %.3f s, %.0f points per second\n", totalPoints, seconds, totalPoints / seconds);
     }
 }
 
-int main()
+// Times CrossingKernel against Scanline on random star shaped polygons of growing size, one line per run,
+// to place KERNEL_MAX_SEGMENTS.
+void benchmarkCrossover() {
+    std::mt19937 generator(1);
+    const TCoord RANGE = 1000000;
+    const size_t POINT_NUMBERS[] = {100000, 1000000};
+    const size_t SEGMENT_NUMBERS[] = {8, 16, 32, 64, 128, 160, 192, 224, 256, 384};
+    for (size_t pointNumber : POINT_NUMBERS) {
+        std::vector<NGeometry::NScanline::Point> points(pointNumber);
+        for (size_t i = 0; i < pointNumber; ++i) {
+            points[i].setX(static_cast<TCoord>(generator() % (2 * RANGE + 1)) - RANGE);
+            points[i].setY(static_cast<TCoord>(generator() % (2 * RANGE + 1)) - RANGE);
+        }
+        for (size_t segmentNumber : SEGMENT_NUMBERS) {
+            std::vector<NGeometry::NScanline::Segment> segments(segmentNumber);
+            std::vector<NGeometry::NScanline::Point> vertices(segmentNumber);
+            for (size_t i = 0; i < segmentNumber; ++i) {
+                double angle = 2 * M_PI * i / segmentNumber;
+                double radius = RANGE * (0.3 + 0.7 * (generator() % 1000) / 1000.0);
+                vertices[i].setX(static_cast<TCoord>(radius * cos(angle)));
+                vertices[i].setY(static_cast<TCoord>(radius * sin(angle)));
+            }
+            for (size_t i = 0; i < segmentNumber; ++i) {
+                segments[i] = NGeometry::NScanline::Segment(vertices[i], vertices[(i + 1) % segmentNumber]);
+            }
+            auto start = std::chrono::steady_clock::now();
+            std::vector<NGeometry::NScanline::TPointPosition> kernel = NGeometry::NScanline::CrossingKernel(segments).solve(points);
+            auto middle = std::chrono::steady_clock::now();
+            std::vector<NGeometry::NScanline::TPointPosition> sweep = NGeometry::NScanline::Scanline(segments, points).solve();
+            auto finish = std::chrono::steady_clock::now();
+            printf("points %zu segments %zu kernel %.4f s scanline %.4f s%s\n", pointNumber, segmentNumber,
+                   std::chrono::duration<double>(middle - start).count(), std::chrono::duration<double>(finish - middle).count(),
+                   kernel == sweep ? "" : " MISMATCH");
+        }
+    }
+}
+
+// Usage: src [--binary-input] [--binary-output] [--stats] [--rings] [--threads N] < input, or src --crossover
+int main(int argc, char* argv[])
 {
-    readAndSolve();
+    bool binaryInput = false, binaryOutput = false, printStats = false, rings = false;
+    size_t threadNumber = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--crossover")) {
+            benchmarkCrossover();
+            return 0;
+        }
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            threadNumber = std::max(atoi(argv[++i]), 0);
+            continue;
+        }
+        binaryInput |= !strcmp(argv[i], "--binary-input");
+        binaryOutput |= !strcmp(argv[i], "--binary-output");
+        printStats |= !strcmp(argv[i], "--stats");
+        rings |= !strcmp(argv[i], "--rings");
+    }
+    readAndSolve(binaryInput, binaryOutput, printStats, rings, threadNumber);
 }
+
+#endif
@@ -0,0 +1,367 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#define SCANLINE_NO_MAIN
+#include "src.cpp"
+
+using namespace NGeometry::NScanline;
+
+namespace {
+    Point makePoint(TCoord x, TCoord y) {
+        Point point;
+        point.setX(x);
+        point.setY(y);
+        return point;
+    }
+
+    std::vector<Segment> makeRing(const std::vector<std::pair<TCoord, TCoord> >& vertices, TCoord dx = 0, TCoord dy = 0) {
+        std::vector<Segment> segments;
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            const std::pair<TCoord, TCoord>& next = vertices[(i + 1) % vertices.size()];
+            segments.push_back(Segment(makePoint(vertices[i].first + dx, vertices[i].second + dy), makePoint(next.first + dx, next.second + dy)));
+        }
+        return segments;
+    }
+
+    bool upperHalf(const std::pair<TCoord, TCoord>& vertex) {
+        return vertex.second > 0 || (vertex.second == 0 && vertex.first > 0);
+    }
+
+    // Random vertices sorted by angle around the origin, at most one per direction: a simple star-shaped polygon.
+    std::vector<Segment> starPolygon(std::mt19937& generator, int vertexNumber, TCoord range, TCoord dx = 0, TCoord dy = 0) {
+        std::vector<std::pair<TCoord, TCoord> > vertices;
+        vertices.push_back(std::make_pair(range, 0));
+        vertices.push_back(std::make_pair(0, range));
+        vertices.push_back(std::make_pair(-range, 0));
+        vertices.push_back(std::make_pair(0, -range));
+        for (int i = 0; i < vertexNumber; ++i) {
+            TCoord x = static_cast<TCoord>(generator() % (2 * range + 1)) - range;
+            TCoord y = static_cast<TCoord>(generator() % (2 * range + 1)) - range;
+            if (x != 0 || y != 0) {
+                vertices.push_back(std::make_pair(x, y));
+            }
+        }
+        std::sort(vertices.begin(), vertices.end(), [] (const std::pair<TCoord, TCoord>& a, const std::pair<TCoord, TCoord>& b) {
+            if (upperHalf(a) != upperHalf(b)) {
+                return upperHalf(a);
+            }
+            return a.first * b.second - a.second * b.first > 0;
+        });
+        std::vector<std::pair<TCoord, TCoord> > directions;
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            if (directions.empty() || upperHalf(directions.back()) != upperHalf(vertices[i])
+                || directions.back().first * vertices[i].second - directions.back().second * vertices[i].first != 0) {
+                directions.push_back(vertices[i]);
+            }
+        }
+        return makeRing(directions, dx, dy);
+    }
+
+    // Convex hull of random points, counterclockwise.
+    std::vector<Segment> convexPolygon(std::mt19937& generator, int vertexNumber, TCoord range) {
+        std::vector<std::pair<TCoord, TCoord> > points;
+        for (int i = 0; i < vertexNumber; ++i) {
+            points.push_back(std::make_pair(static_cast<TCoord>(generator() % (2 * range + 1)) - range,
+                                            static_cast<TCoord>(generator() % (2 * range + 1)) - range));
+        }
+        std::sort(points.begin(), points.end());
+        points.erase(std::unique(points.begin(), points.end()), points.end());
+        auto turn = [] (const std::pair<TCoord, TCoord>& a, const std::pair<TCoord, TCoord>& b, const std::pair<TCoord, TCoord>& c) {
+            return (b.first - a.first) * (c.second - a.second) - (b.second - a.second) * (c.first - a.first);
+        };
+        std::vector<std::pair<TCoord, TCoord> > hull(2 * points.size());
+        size_t size = 0;
+        for (size_t i = 0; i < points.size(); ++i) {
+            while (size >= 2 && turn(hull[size - 2], hull[size - 1], points[i]) <= 0) {
+                --size;
+            }
+            hull[size++] = points[i];
+        }
+        for (size_t i = points.size() - 1, lower = size + 1; i-- > 0;) {
+            while (size >= lower && turn(hull[size - 2], hull[size - 1], points[i]) <= 0) {
+                --size;
+            }
+            hull[size++] = points[i];
+        }
+        hull.resize(size - 1);
+        return makeRing(hull);
+    }
+
+    // Every lattice point of the square, so vertices and edges are hit as often as the interior.
+    std::vector<Point> latticePoints(TCoord range) {
+        std::vector<Point> points;
+        for (TCoord x = -range; x <= range; ++x) {
+            for (TCoord y = -range; y <= range; ++y) {
+                points.push_back(makePoint(x, y));
+            }
+        }
+        return points;
+    }
+
+    bool onSegment(const Segment& segment, TCoord x, TCoord y) {
+        TCoord x1 = segment.getStart().getX(), y1 = segment.getStart().getY();
+        TCoord x2 = segment.getFinish().getX(), y2 = segment.getFinish().getY();
+        return (x2 - x1) * (y - y1) == (y2 - y1) * (x - x1) && std::min(x1, x2) <= x && x <= std::max(x1, x2)
+               && std::min(y1, y2) <= y && y <= std::max(y1, y2);
+    }
+
+    // Crossing number of the downward ray, an edge counts for x in [left end, right end).
+    bool crossesBelow(const Segment& segment, TCoord x, TCoord y) {
+        Point left = segment.getStart(), right = segment.getFinish();
+        if (left.getX() > right.getX()) {
+            std::swap(left, right);
+        }
+        if (!(left.getX() <= x && x < right.getX())) {
+            return false;
+        }
+        return (right.getX() - left.getX()) * (y - left.getY()) - (right.getY() - left.getY()) * (x - left.getX()) > 0;
+    }
+
+    TPointPosition bruteLocate(const std::vector<std::vector<Segment> >& rings, TCoord x, TCoord y) {
+        bool inside = false;
+        for (size_t ring = 0; ring < rings.size(); ++ring) {
+            for (size_t i = 0; i < rings[ring].size(); ++i) {
+                if (onSegment(rings[ring][i], x, y)) {
+                    return BORDER;
+                }
+                inside ^= crossesBelow(rings[ring][i], x, y);
+            }
+        }
+        return inside ? INSIDE : OUTSIDE;
+    }
+
+    TPointPosition bruteLocate(const std::vector<Segment>& segments, TCoord x, TCoord y) {
+        return bruteLocate(std::vector<std::vector<Segment> >(1, segments), x, y);
+    }
+
+    std::vector<TPointPosition> bruteSolve(const std::vector<std::vector<Segment> >& rings, const std::vector<Point>& points) {
+        std::vector<TPointPosition> positions;
+        for (size_t i = 0; i < points.size(); ++i) {
+            positions.push_back(bruteLocate(rings, points[i].getX(), points[i].getY()));
+        }
+        return positions;
+    }
+
+    std::vector<TPointPosition> bruteSolve(const std::vector<Segment>& segments, const std::vector<Point>& points) {
+        return bruteSolve(std::vector<std::vector<Segment> >(1, segments), points);
+    }
+}
+
+TEST(PolygonIndex, matchesBruteForce) {
+    std::mt19937 generator(5);
+    const TCoord RANGE = 12;
+    for (int test = 0; test < 200; ++test) {
+        std::vector<Segment> segments = starPolygon(generator, 3 + generator() % 40, RANGE - 1);
+        PolygonIndex index(segments);
+        for (TCoord x = -RANGE; x <= RANGE; ++x) {
+            for (TCoord y = -RANGE; y <= RANGE; ++y) {
+                EXPECT_EQ(index.locate(x, y), bruteLocate(segments, x, y));
+            }
+        }
+    }
+}
+
+TEST(SpatialJoin, matchesBruteForce) {
+    std::mt19937 generator(8);
+    const TCoord RANGE = 20;
+    for (int test = 0; test < 50; ++test) {
+        // Overlapping stars, each of them tested on its own.
+        std::vector<std::vector<Segment> > polygons;
+        for (int polygon = 0; polygon < 6; ++polygon) {
+            polygons.push_back(starPolygon(generator, 3 + generator() % 20, 4 + generator() % 8,
+                                           static_cast<TCoord>(generator() % 21) - 10, static_cast<TCoord>(generator() % 21) - 10));
+        }
+        std::vector<Point> points = latticePoints(RANGE);
+        std::vector<JoinMatch> matches = SpatialJoin(polygons, points).solve();
+        size_t match = 0;
+        for (size_t point = 0; point < points.size(); ++point) {
+            for (size_t polygon = 0; polygon < polygons.size(); ++polygon) {
+                TPointPosition expected = bruteLocate(polygons[polygon], points[point].getX(), points[point].getY());
+                if (expected == OUTSIDE) {
+                    continue;
+                }
+                ASSERT_LT(match, matches.size());
+                EXPECT_EQ(matches[match].point, point);
+                EXPECT_EQ(matches[match].polygon, polygon);
+                EXPECT_EQ(matches[match].position, expected);
+                ++match;
+            }
+        }
+        EXPECT_EQ(match, matches.size());
+    }
+}
+
+TEST(Scanline, matchesBruteForce) {
+    std::mt19937 generator(1);
+    const TCoord RANGE = 12;
+    for (int test = 0; test < 200; ++test) {
+        std::vector<Segment> segments = starPolygon(generator, 3 + generator() % 40, RANGE - 1);
+        std::vector<Point> points = latticePoints(RANGE);
+        std::vector<TPointPosition> expected = bruteSolve(segments, points);
+        std::vector<Segment> polygon = segments;
+        EXPECT_EQ(Scanline(polygon, points).solve(), expected) << "test " << test;
+        polygon = segments;
+        EXPECT_EQ(Scanline(polygon, points).solve(3), expected) << "test " << test;
+    }
+}
+
+TEST(Scanline, wideCoordinatesMatchBruteForce) {
+    std::mt19937 generator(9);
+    const TCoord RANGE = 12, SCALE = 50000017, SHIFT_X = -(1LL << 40), SHIFT_Y = 1LL << 36;
+    for (int test = 0; test < 100; ++test) {
+        // A scaled and shifted star, so the radix sort needs several digits of both keys.
+        std::vector<Segment> segments = starPolygon(generator, 3 + generator() % 40, RANGE - 1);
+        std::vector<Point> points = latticePoints(RANGE);
+        std::shuffle(points.begin(), points.end(), generator);
+        std::vector<TPointPosition> expected = bruteSolve(segments, points);
+        for (size_t i = 0; i < segments.size(); ++i) {
+            segments[i] = Segment(makePoint(segments[i].getStart().getX() * SCALE + SHIFT_X, segments[i].getStart().getY() * SCALE + SHIFT_Y),
+                                  makePoint(segments[i].getFinish().getX() * SCALE + SHIFT_X, segments[i].getFinish().getY() * SCALE + SHIFT_Y));
+        }
+        for (size_t i = 0; i < points.size(); ++i) {
+            points[i] = makePoint(points[i].getX() * SCALE + SHIFT_X, points[i].getY() * SCALE + SHIFT_Y);
+        }
+        EXPECT_EQ(Scanline(segments, points).solve(), expected) << "test " << test;
+    }
+}
+
+TEST(InputBuffer, readsMappedFilesAndPipes) {
+    const char TEXT[] = "3\n-12 7  300000000000\r\n-0 x 5";
+    const long long TEXT_NUMBERS[] = {3, -12, 7, 300000000000LL, 0, 5};
+    const long long BINARY_NUMBERS[] = {-1, 1LL << 40, 0, 42};
+    for (int source = 0; source < 2; ++source) {
+        for (int binary = 0; binary < 2; ++binary) {
+            const char* data = binary ? reinterpret_cast<const char*>(BINARY_NUMBERS) : TEXT;
+            size_t size = binary ? sizeof(BINARY_NUMBERS) : sizeof(TEXT) - 1;
+            // A regular file is mapped, a pipe is read in blocks.
+            int fd;
+            FILE* file = nullptr;
+            if (source == 0) {
+                file = tmpfile();
+                ASSERT_NE(file, nullptr);
+                ASSERT_EQ(fwrite(data, 1, size, file), size);
+                fflush(file);
+                fd = fileno(file);
+            } else {
+                int ends[2];
+                ASSERT_EQ(pipe(ends), 0);
+                ASSERT_EQ(write(ends[1], data, size), static_cast<ssize_t>(size));
+                close(ends[1]);
+                fd = ends[0];
+            }
+            {
+                InputBuffer input(fd);
+                if (binary) {
+                    for (long long number : BINARY_NUMBERS) {
+                        EXPECT_EQ(input.readBinary(), number);
+                    }
+                    EXPECT_EQ(input.readBinary(), 0);
+                } else {
+                    for (long long number : TEXT_NUMBERS) {
+                        EXPECT_EQ(input.readInt(), number);
+                    }
+                    EXPECT_EQ(input.readInt(), 0);
+                }
+            }
+            if (file) {
+                fclose(file);
+            } else {
+                close(fd);
+            }
+        }
+    }
+}
+
+TEST(CrossingKernel, matchesBruteForce) {
+    std::mt19937 generator(7);
+    const TCoord RANGE = 12;
+    for (int test = 0; test < 200; ++test) {
+        std::vector<Segment> segments = starPolygon(generator, 3 + generator() % 40, RANGE - 1);
+        CrossingKernel kernel(segments);
+        std::vector<Point> points = latticePoints(RANGE);
+        std::vector<TPointPosition> expected = bruteSolve(segments, points);
+        EXPECT_EQ(kernel.solve(points), expected) << "test " << test;
+        for (size_t i = 0; i < points.size(); ++i) {
+            EXPECT_EQ(kernel.locate(points[i].getX(), points[i].getY()), expected[i]);
+        }
+    }
+}
+
+TEST(Scanline, locatePointsOnEveryPath) {
+    std::mt19937 generator(4);
+    const TCoord RANGE = 40;
+    for (int test = 0; test < 20; ++test) {
+        // Below and above KERNEL_MAX_SEGMENTS.
+        std::vector<Segment> segments = starPolygon(generator, test % 2 == 0 ? 50 : 400, RANGE - 1);
+        std::vector<Point> points = latticePoints(RANGE);
+        std::vector<TPointPosition> expected = bruteSolve(segments, points);
+        for (size_t threadNumber = 0; threadNumber < 3; ++threadNumber) {
+            std::vector<Segment> polygon = segments;
+            EXPECT_EQ(locatePoints(polygon, points, threadNumber), expected) << "test " << test;
+        }
+    }
+}
+
+TEST(Scanline, convexPolygons) {
+    std::mt19937 generator(2);
+    const TCoord RANGE = 12;
+    for (int test = 0; test < 200; ++test) {
+        std::vector<Segment> segments = convexPolygon(generator, 3 + generator() % 30, RANGE - 1);
+        if (segments.size() < 3) {
+            continue;
+        }
+        EXPECT_TRUE(ConvexPolygon(segments).isConvex());
+        std::vector<Point> points = latticePoints(RANGE);
+        std::vector<TPointPosition> expected = bruteSolve(segments, points);
+        ConvexPolygon convex(segments);
+        for (size_t i = 0; i < points.size(); ++i) {
+            EXPECT_EQ(convex.locate(points[i].getX(), points[i].getY()), expected[i]);
+        }
+        std::vector<Segment> polygon = segments;
+        EXPECT_EQ(Scanline(polygon, points).solve(), expected);
+    }
+}
+
+TEST(GridIndex, matchesBruteForce) {
+    std::mt19937 generator(6);
+    const TCoord RANGE = 12;
+    for (int test = 0; test < 200; ++test) {
+        std::vector<Segment> segments = test % 2 == 0 ? starPolygon(generator, 3 + generator() % 40, RANGE - 1)
+                                                      : convexPolygon(generator, 3 + generator() % 30, RANGE - 1);
+        if (segments.size() < 3) {
+            continue;
+        }
+        GridIndex index(segments);
+        std::vector<Point> points = latticePoints(RANGE);
+        EXPECT_EQ(index.solve(points), bruteSolve(segments, points)) << "test " << test;
+    }
+}
+
+TEST(Scanline, ringsMatchBruteForce) {
+    std::mt19937 generator(3);
+    const TCoord RANGE = 24;
+    std::vector<std::pair<TCoord, TCoord> > square;
+    square.push_back(std::make_pair(-RANGE + 1, -RANGE + 1));
+    square.push_back(std::make_pair(RANGE - 1, -RANGE + 1));
+    square.push_back(std::make_pair(RANGE - 1, RANGE - 1));
+    square.push_back(std::make_pair(-RANGE + 1, RANGE - 1));
+    for (int test = 0; test < 100; ++test) {
+        std::vector<std::vector<Segment> > rings;
+        if (test % 2 == 0) {
+            // A square with two star holes.
+            rings.push_back(makeRing(square));
+            rings.push_back(starPolygon(generator, 3 + generator() % 20, 8, -11, -11));
+            rings.push_back(starPolygon(generator, 3 + generator() % 20, 8, 11, 11));
+        } else {
+            // Three disjoint stars.
+            for (int part = 0; part < 3; ++part) {
+                rings.push_back(starPolygon(generator, 3 + generator() % 20, 7, 16 * (part - 1), 0));
+            }
+        }
+        std::vector<Point> points = latticePoints(RANGE);
+        std::vector<TPointPosition> expected = bruteSolve(rings, points);
+        std::vector<std::vector<Segment> > polygon = rings;
+        EXPECT_EQ(Scanline(polygon, points).solve(), expected) << "test " << test;
+        polygon = rings;
+        EXPECT_EQ(locatePoints(polygon, points, 2), expected) << "test " << test;
+    }
+}